@@ -7,11 +7,46 @@
 #include <any>
 #include <sqlite3.h>
 #include <stdexcept>
+#include <memory_resource>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <ctime>
+#include <chrono>
+#include <iomanip>
+#include <unordered_map>
+#include <iterator>
+#include <cctype>
+#include <unordered_set>
+#include <sstream>
+#include <random>
 
 
 enum class Priority {Low, Medium, High};
 enum class Status {Open, InProgress, Done};
 
+void printTaskFields(std::string_view title, std::string_view category, std::string_view dueDate, Priority priority, Status status) {
+	std::cout << "Title: " << title << ", Category: " << category << ", Due Date: " << dueDate;
+	switch(priority) {
+		case Priority::Low: std::cout << ", Priority: \033[32mLow\033[0m"; break;
+		case Priority::Medium: std::cout << ", Priority: \033[33mMedium\033[0m"; break;
+		case Priority::High: std::cout << ", Priority: \033[31mHigh\033[0m"; break;
+	}
+	switch(status) {
+		case Status::Open: std::cout << ", Status: Open" << std::endl; break;
+		case Status::InProgress: std::cout << ", Status: In Progress" << std::endl; break;
+		case Status::Done: std::cout << ", Status: Done" << std::endl; break;
+	}
+}
+
 class Task {
 	private:
 		std::string title;
@@ -36,368 +71,3533 @@ class Task {
 		void setStatus(Status stat) { status = stat; }
 
 		void print() const {
-			std::cout << "Title: " << title << ", Category: " << category << ", Due Date: " << dueDate;
-			switch(priority) {
-				case Priority::Low: std::cout << ", Priority: \033[32mLow\033[0m"; break;
-				case Priority::Medium: std::cout << ", Priority: \033[33mMedium\033[0m"; break;
-				case Priority::High: std::cout << ", Priority: \033[31mHigh\033[0m"; break;
-			}		
-			switch(status) {
-				case Status::Open: std::cout << ", Status: Open" << std::endl; break;
-				case Status::InProgress: std::cout << ", Status: In Progress" << std::endl; break;
-				case Status::Done: std::cout << ", Status: Done" << std::endl; break;
-			}
+			printTaskFields(title, category, dueDate, priority, status);
 		}
 };
 
-class TaskManager {
+// One row of a TaskBatch. The strings are views into the batch's arena and
+// are only valid as long as the batch lives.
+struct TaskRecord {
+	std::string_view title;
+	std::string_view category;
+	std::string_view dueDate;
+	Priority priority;
+	Status status;
+
+	// View of a Task; valid as long as the Task is.
+	static TaskRecord of(const Task& task) {
+		return TaskRecord{task.getTitle(), task.getCategory(), task.getDueDate(), task.getPriority(), task.getStatus()};
+	}
+
+	// View of the current row of a 'SELECT * FROM tasks' statement; valid until the next step.
+	static TaskRecord ofRow(sqlite3_stmt* stmt) {
+		auto text = [stmt](int column) {
+			const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+			return value ? std::string_view(value, sqlite3_column_bytes(stmt, column)) : std::string_view();
+		};
+		return TaskRecord{text(0), text(1), text(2), static_cast<Priority>(sqlite3_column_int(stmt, 3)),
+			static_cast<Status>(sqlite3_column_int(stmt, 4))};
+	}
+
+	Task toTask() const {
+		return Task(std::string(title), std::string(category), std::string(dueDate), priority, status);
+	}
+
+	void print() const {
+		printTaskFields(title, category, dueDate, priority, status);
+	}
+};
+
+// Result set for bulk queries. All records and their strings live in one
+// monotonic arena, so filling a batch costs a handful of allocations instead of
+// three per row, and everything is released in one step when the batch dies.
+class TaskBatch {
 	private:
-		sqlite3* db;
+		// Rough guess for title + category + dueDate of one row, used to pre-size the arena.
+		static constexpr size_t BYTES_PER_ROW = 48;
+
+		std::pmr::monotonic_buffer_resource arena;
+		std::pmr::vector<TaskRecord> records;
+
+		std::string_view store(std::string_view text) {
+			if (text.empty()) {
+				return std::string_view();
+			}
+			char* buffer = static_cast<char*>(arena.allocate(text.size(), 1));
+			std::memcpy(buffer, text.data(), text.size());
+			return std::string_view(buffer, text.size());
+		}
 
 	public:
-		TaskManager() {
-			if (sqlite3_open("./data/tasks_sql.db", &db) != SQLITE_OK) {
-				std::string errorMsg = sqlite3_errmsg(db);
-				sqlite3_close(db);
-				throw std::runtime_error("Failed to open database: " + errorMsg);
+		explicit TaskBatch(size_t rowHint = 0)
+			: arena(rowHint * (sizeof(TaskRecord) + BYTES_PER_ROW) + BYTES_PER_ROW), records(&arena)
+		{
+			records.reserve(rowHint);
+		}
+
+		TaskBatch(const TaskBatch&) = delete;
+		TaskBatch& operator=(const TaskBatch&) = delete;
+
+		// Copies the current row of a 'SELECT * FROM tasks' statement into the arena.
+		void append(sqlite3_stmt* stmt) {
+			append(TaskRecord::ofRow(stmt));
+		}
+
+		// Copies a record (and the strings it points to) into the arena.
+		void append(const TaskRecord& record) {
+			records.push_back(TaskRecord{store(record.title), store(record.category), store(record.dueDate),
+				record.priority, record.status});
+		}
+
+		size_t size() const { return records.size(); }
+		bool empty() const { return records.empty(); }
+		const TaskRecord& operator[](size_t i) const { return records[i]; }
+		std::pmr::vector<TaskRecord>::const_iterator begin() const { return records.begin(); }
+		std::pmr::vector<TaskRecord>::const_iterator end() const { return records.end(); }
+
+		std::vector<Task> toTasks() const {
+			std::vector<Task> tasks;
+			tasks.reserve(records.size());
+			for (const TaskRecord& record : records) {
+				tasks.push_back(record.toTask());
 			}
+			return tasks;
+		}
+};
 
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				CREATE TABLE IF NOT EXISTS tasks (
-					title 		TEXT		PRIMARY KEY,
-					category	TEXT		NOT NULL,
-					dueDate		TEXT		NOT NULL,
-					priority	INTEGER		NOT NULL,
-					status		INTEGER		NOT NULL
-					);
-				)", -1, &stmt, nullptr);
-				
-			sqlite3_step(stmt);
-			sqlite3_finalize(stmt);
+// Conditions for the bulk operations (setStatusWhere, setPriorityWhere, removeWhere).
+// Unset fields match every task; set fields are combined with AND.
+struct TaskFilter {
+	std::optional<std::string> category;
+	std::optional<Priority> priority;
+	std::optional<Status> status;
+	std::optional<std::string> dueBefore;	// DD-MM-YYYY, matches tasks due strictly before this day
+
+	bool empty() const {
+		return !category && !priority && !status && !dueBefore;
+	}
+};
+
+// Days since 01-01-1970 for a calendar date.
+long long civilToDays(long long year, long long month, long long day) {
+	// Years start in March here, so leap days come last.
+	year -= month <= 2;
+	const long long era = (year >= 0 ? year : year - 399) / 400;
+	const long long yearOfEra = year - era * 400;
+	const long long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	const long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+// Days since 01-01-1970 for a DD-MM-YYYY date (any separator).
+long long dateToDays(const std::string& date) {
+	return civilToDays(std::stoi(date.substr(6, 4)), std::stoi(date.substr(3, 2)), std::stoi(date.substr(0, 2)));
+}
+
+enum class DateCheck {Valid, BadFormat, BadDay};
+
+// Checks a DD-MM-YYYY due date; '/', '.' and ',' are accepted as separators too.
+DateCheck checkDate(const std::string& date) {
+	const int MIN = 1;
+    const int MONTHS = 12;
+    const int LONG_MONTH_DAYS = 31;
+    const int SHORT_MONTH_DAYS = 30;
+    const int FEBRUARY_DAYS = 28;
+    const int LEAP_FEBRUARY_DAYS = 29;
+
+    const std::vector<int> SHORT_MONTHS = {4,6,9,11};
+    const int FEBRUARY_MONTH = 2;
+
+    const int DATE_LENGTH = 10;
+
+    const std::vector<char> SEPARATORS = {'-', '/', '.', ','};
+
+    if (date.size() != DATE_LENGTH) {
+        return DateCheck::BadFormat;
+    }
+    if ((std::find(SEPARATORS.begin(), SEPARATORS.end(), date[2]) == SEPARATORS.end()) ||
+    (std::find(SEPARATORS.begin(), SEPARATORS.end(), date[5]) == SEPARATORS.end())) {
+        return DateCheck::BadFormat;
+    }
+    for (size_t i : {0, 1, 3, 4, 6, 7, 8, 9}) {
+        if (!std::isdigit(static_cast<unsigned char>(date[i]))) {
+            return DateCheck::BadFormat;
+        }
+    }
+
+    int day = std::stoi(date.substr(0,2));
+    int month = std::stoi(date.substr(3,2));
+    int year = std::stoi(date.substr(6,4));
+    if (day < MIN || month < MIN || month > MONTHS || year < MIN) {
+        return DateCheck::BadDay;
+    }
+
+    int max_days = LONG_MONTH_DAYS;
+    if (month == FEBRUARY_MONTH) {
+        bool leap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+        max_days = leap ? LEAP_FEBRUARY_DAYS : FEBRUARY_DAYS;
+    }
+    else if (std::find(SHORT_MONTHS.begin(), SHORT_MONTHS.end(), month) != SHORT_MONTHS.end()) {
+        max_days = SHORT_MONTH_DAYS;
+    }
+    return day <= max_days ? DateCheck::Valid : DateCheck::BadDay;
+}
+
+bool isValidDate(const std::string& date) {
+	return checkDate(date) == DateCheck::Valid;
+}
+
+// DD-MM-YYYY for a day count from dateToDays.
+std::string daysToDate(long long days) {
+	days += 719468;
+	const long long era = (days >= 0 ? days : days - 146096) / 146097;
+	const long long dayOfEra = days - era * 146097;
+	const long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	const long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	const long long shiftedMonth = (5 * dayOfYear + 2) / 153;
+	const long long day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+	const long long month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+	const long long year = yearOfEra + era * 400 + (month <= 2);
+
+	std::ostringstream date;
+	date << std::setfill('0') << std::setw(2) << day << '-' << std::setw(2) << month << '-' << std::setw(4) << year;
+	return date.str();
+}
+
+// Day count of the local date today.
+long long todayDays() {
+	std::time_t now = std::time(nullptr);
+	std::tm local = *std::localtime(&now);
+	return civilToDays(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// 0 = Monday ... 6 = Sunday. 01-01-1970 was a Thursday.
+int weekdayOf(long long days) {
+	return static_cast<int>(((days % 7) + 7 + 3) % 7);
+}
+
+enum class Repeat {Days, Weeks, Weekday, MonthDay};
+
+// A task template that repeats. Only the rule is stored; its occurrences are computed
+// for the dates that are asked for and are titled "<title> @ DD-MM-YYYY".
+struct RecurrenceRule {
+	std::string title;
+	std::string category;
+	Priority priority;
+	Repeat repeat;
+	int every;		// Days/Weeks: interval, Weekday: 0 = Monday .. 6 = Sunday, MonthDay: 1-31
+	std::string startDate;
+	std::optional<std::string> endDate;
+
+	std::string occurrenceTitle(long long day) const {
+		return title + " @ " + daysToDate(day);
+	}
+
+	// Due days of all occurrences in [from, to]. Costs O(number of occurrences in range).
+	std::vector<long long> occurrences(long long from, long long to) const {
+		const long long start = dateToDays(startDate);
+		const long long first = std::max(from, start);
+		const long long last = endDate ? std::min(to, dateToDays(*endDate)) : to;
+
+		std::vector<long long> days;
+		if (first > last || (every <= 0 && repeat != Repeat::Weekday)) {
+			return days;
+		}
+		switch (repeat) {
+			case Repeat::Days:
+			case Repeat::Weeks: {
+				const long long period = repeat == Repeat::Weeks ? 7ll * every : every;
+				for (long long day = start + (first - start + period - 1) / period * period; day <= last; day += period) {
+					days.push_back(day);
+				}
+				break;
+			}
+			case Repeat::Weekday:
+				for (long long day = first + (every - weekdayOf(first) + 7) % 7; day <= last; day += 7) {
+					days.push_back(day);
+				}
+				break;
+			case Repeat::MonthDay: {
+				// Months without that day use their last day instead.
+				const std::string firstDate = daysToDate(first);
+				long long year = std::stoi(firstDate.substr(6, 4));
+				long long month = std::stoi(firstDate.substr(3, 2));
+				while (true) {
+					const long long monthStart = civilToDays(year, month, 1);
+					const long long nextStart = month == 12 ? civilToDays(year + 1, 1, 1) : civilToDays(year, month + 1, 1);
+					if (monthStart > last) {
+						break;
+					}
+					const long long day = monthStart + std::min<long long>(every, nextStart - monthStart) - 1;
+					if (day >= first && day <= last) {
+						days.push_back(day);
+					}
+					year += month == 12;
+					month = month == 12 ? 1 : month + 1;
+				}
+				break;
+			}
+		}
+		return days;
+	}
+};
+
+// Ranking for the "Next tasks" agenda. Lower scores come first. The score is the due day,
+// moved 'daysPerPriority' days earlier for every priority level above Low.
+struct AgendaScore {
+	long long daysPerPriority = 7;
+
+	long long operator()(const std::string& dueDate, Priority priority) const {
+		return dateToDays(dueDate) - daysPerPriority * static_cast<long long>(priority);
+	}
+};
+
+// d-ary min-heap of task titles with a title -> slot map. Inserting, re-keying and
+// removing a task cost O(log n), so the agenda never has to be rebuilt on edits.
+class AgendaHeap {
+	private:
+		static constexpr size_t ARITY = 4;
+
+		struct Entry {
+			long long score;
+			std::string title;
 		};
 
-		~TaskManager() {
-			sqlite3_close(db);
+		std::vector<Entry> heap;
+		std::unordered_map<std::string, size_t> position;
+
+		static bool before(const Entry& a, const Entry& b) {
+			return a.score != b.score ? a.score < b.score : a.title < b.title;
 		}
 
+		void place(size_t slot, Entry entry) {
+			position[entry.title] = slot;
+			heap[slot] = std::move(entry);
+		}
 
-		std::vector<Task> getAllTasks() const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks;
+		void siftUp(size_t slot) {
+			Entry entry = std::move(heap[slot]);
+			while (slot > 0) {
+				size_t parent = (slot - 1) / ARITY;
+				if (!before(entry, heap[parent])) {
+					break;
+				}
+				place(slot, std::move(heap[parent]));
+				slot = parent;
+			}
+			place(slot, std::move(entry));
+		}
+
+		void siftDown(size_t slot) {
+			Entry entry = std::move(heap[slot]);
+			while (true) {
+				size_t first = slot * ARITY + 1;
+				if (first >= heap.size()) {
+					break;
+				}
+				size_t best = first;
+				for (size_t child = first + 1; child < std::min(first + ARITY, heap.size()); child++) {
+					if (before(heap[child], heap[best])) {
+						best = child;
+					}
+				}
+				if (!before(heap[best], entry)) {
+					break;
+				}
+				place(slot, std::move(heap[best]));
+				slot = best;
+			}
+			place(slot, std::move(entry));
+		}
+
+	public:
+		size_t size() const { return heap.size(); }
+		bool contains(const std::string& title) const { return position.count(title) > 0; }
+
+		void clear() {
+			heap.clear();
+			position.clear();
+		}
+
+		// Inserts the task or changes its score.
+		void upsert(const std::string& title, long long score) {
+			auto found = position.find(title);
+			if (found == position.end()) {
+				heap.push_back(Entry{score, title});
+				position[title] = heap.size() - 1;
+				siftUp(heap.size() - 1);
+				return;
+			}
+			size_t slot = found->second;
+			long long oldScore = heap[slot].score;
+			heap[slot].score = score;
+			if (score < oldScore) {
+				siftUp(slot);
+			}
+			else {
+				siftDown(slot);
+			}
+		}
+
+		bool erase(const std::string& title) {
+			auto found = position.find(title);
+			if (found == position.end()) {
+				return false;
+			}
+			size_t slot = found->second;
+			position.erase(found);
+			if (slot == heap.size() - 1) {
+				heap.pop_back();
+				return true;
+			}
+			heap[slot] = std::move(heap.back());
+			heap.pop_back();
+			position[heap[slot].title] = slot;
+			if (slot > 0 && before(heap[slot], heap[(slot - 1) / ARITY])) {
+				siftUp(slot);
+			}
+			else {
+				siftDown(slot);
+			}
+			return true;
+		}
+
+		// The k best titles in order, without touching the heap. Walks the heap with a
+		// small frontier queue, so it costs O(k log k) <= O(k log n).
+		std::vector<std::string> top(size_t k) const {
+			auto worse = [this](size_t a, size_t b) { return before(heap[b], heap[a]); };
+			std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> frontier(worse);
+			if (!heap.empty()) {
+				frontier.push(0);
+			}
+
+			std::vector<std::string> titles;
+			while (titles.size() < k && !frontier.empty()) {
+				size_t slot = frontier.top();
+				frontier.pop();
+				titles.push_back(heap[slot].title);
+				for (size_t child = slot * ARITY + 1; child < std::min(slot * ARITY + 1 + ARITY, heap.size()); child++) {
+					frontier.push(child);
+				}
+			}
+			return titles;
+		}
+};
+
+// Dense ids for task titles, used as node ids of the dependency graph. Ids of removed
+// tasks are never handed out again.
+class TaskIndex {
+	private:
+		std::unordered_map<std::string, uint32_t> ids;
+		std::vector<std::string> titles;
+
+	public:
+		uint32_t intern(const std::string& title) {
+			auto found = ids.find(title);
+			if (found != ids.end()) {
+				return found->second;
+			}
+			uint32_t id = static_cast<uint32_t>(titles.size());
+			ids.emplace(title, id);
+			titles.push_back(title);
+			return id;
+		}
+
+		std::optional<uint32_t> find(const std::string& title) const {
+			auto found = ids.find(title);
+			if (found == ids.end()) {
+				return std::nullopt;
+			}
+			return found->second;
+		}
+
+		void forget(const std::string& title) { ids.erase(title); }
+
+		const std::string& title(uint32_t id) const { return titles[id]; }
+		size_t size() const { return titles.size(); }
+
+		void clear() {
+			ids.clear();
+			titles.clear();
+		}
+};
+
+// "Blocker must be done before blocked" edges between tasks. The topological order is
+// kept up to date on every edge insert (Pearce-Kelly), which only reorders the nodes
+// between the two endpoints instead of sorting the whole graph again. Inserts that
+// would close a cycle are rejected.
+class DependencyGraph {
+	private:
+		std::vector<std::vector<uint32_t>> successors;		// blocker -> blocked
+		std::vector<std::vector<uint32_t>> predecessors;	// blocked -> blockers
+		std::vector<uint32_t> rank;							// position of a node in 'order'
+		std::vector<uint32_t> order;						// topological order, may contain dead nodes
+		std::vector<uint32_t> openBlockers;					// blockers that are not done yet
+		std::vector<long long> dueDay;
+		std::vector<char> done;
+		std::vector<char> alive;
+		std::vector<char> visited;							// scratch space for the searches
+
+		static bool eraseValue(std::vector<uint32_t>& values, uint32_t value) {
+			auto found = std::find(values.begin(), values.end(), value);
+			if (found == values.end()) {
+				return false;
+			}
+			*found = values.back();
+			values.pop_back();
+			return true;
+		}
+
+		// Collects the nodes reachable from 'start' (forward or backward) whose rank lies
+		// strictly inside the window. Returns false if 'target' is reached.
+		bool collect(uint32_t start, bool forward, uint32_t lowerRank, uint32_t upperRank, uint32_t target,
+			std::vector<uint32_t>& found) {
+			std::vector<uint32_t> stack = {start};
+			visited[start] = 1;
+			found.push_back(start);
+			while (!stack.empty()) {
+				uint32_t node = stack.back();
+				stack.pop_back();
+				for (uint32_t next : forward ? successors[node] : predecessors[node]) {
+					if (next == target) {
+						return false;
+					}
+					if (!visited[next] && rank[next] > lowerRank && rank[next] < upperRank) {
+						visited[next] = 1;
+						found.push_back(next);
+						stack.push_back(next);
+					}
+				}
+			}
+			return true;
+		}
+
+	public:
+		size_t size() const { return alive.size(); }
+
+		void clear() {
+			successors.clear();
+			predecessors.clear();
+			rank.clear();
+			order.clear();
+			openBlockers.clear();
+			dueDay.clear();
+			done.clear();
+			alive.clear();
+			visited.clear();
+		}
+
+		// Adds a task without edges at the end of the topological order.
+		void addNode(uint32_t id, long long due, bool isDone) {
+			if (id >= alive.size()) {
+				size_t count = id + 1;
+				successors.resize(count);
+				predecessors.resize(count);
+				rank.resize(count, 0);
+				openBlockers.resize(count, 0);
+				dueDay.resize(count, 0);
+				done.resize(count, 0);
+				alive.resize(count, 0);
+				visited.resize(count, 0);
+			}
+			rank[id] = static_cast<uint32_t>(order.size());
+			order.push_back(id);
+			dueDay[id] = due;
+			done[id] = isDone;
+			alive[id] = 1;
+		}
+
+		void removeNode(uint32_t id) {
+			if (id >= alive.size() || !alive[id]) {
+				return;
+			}
+			for (uint32_t blocked : std::vector<uint32_t>(successors[id])) {
+				removeEdge(id, blocked);
+			}
+			for (uint32_t blocker : std::vector<uint32_t>(predecessors[id])) {
+				removeEdge(blocker, id);
+			}
+			alive[id] = 0;
+		}
+
+		bool hasEdge(uint32_t blocker, uint32_t blocked) const {
+			const std::vector<uint32_t>& next = successors[blocker];
+			return std::find(next.begin(), next.end(), blocked) != next.end();
+		}
+
+		// Returns false (and changes nothing) if the edge would create a cycle.
+		bool addEdge(uint32_t blocker, uint32_t blocked) {
+			if (blocker == blocked) {
+				return false;
+			}
+			if (hasEdge(blocker, blocked)) {
+				return true;
+			}
+
+			uint32_t lowerRank = rank[blocked];
+			uint32_t upperRank = rank[blocker];
+			if (lowerRank < upperRank) {
+				// 'blocked' currently comes first. Move everything that depends on it behind
+				// everything 'blocker' depends on, using only the ranks in between.
+				std::vector<uint32_t> forward, backward;
+				bool acyclic = collect(blocked, true, lowerRank, upperRank, blocker, forward);
+				if (acyclic) {
+					acyclic = collect(blocker, false, lowerRank, upperRank, blocked, backward);
+				}
+				for (uint32_t node : forward) { visited[node] = 0; }
+				for (uint32_t node : backward) { visited[node] = 0; }
+				if (!acyclic) {
+					return false;
+				}
+
+				auto byRank = [this](uint32_t a, uint32_t b) { return rank[a] < rank[b]; };
+				std::sort(forward.begin(), forward.end(), byRank);
+				std::sort(backward.begin(), backward.end(), byRank);
+
+				std::vector<uint32_t> nodes = backward;
+				nodes.insert(nodes.end(), forward.begin(), forward.end());
+				std::vector<uint32_t> ranks;
+				for (uint32_t node : nodes) {
+					ranks.push_back(rank[node]);
+				}
+				std::sort(ranks.begin(), ranks.end());
+				for (size_t i = 0; i < nodes.size(); i++) {
+					rank[nodes[i]] = ranks[i];
+					order[ranks[i]] = nodes[i];
+				}
+			}
+
+			successors[blocker].push_back(blocked);
+			predecessors[blocked].push_back(blocker);
+			if (!done[blocker]) {
+				openBlockers[blocked]++;
+			}
+			return true;
+		}
+
+		bool removeEdge(uint32_t blocker, uint32_t blocked) {
+			if (!eraseValue(successors[blocker], blocked)) {
+				return false;
+			}
+			eraseValue(predecessors[blocked], blocker);
+			if (!done[blocker]) {
+				openBlockers[blocked]--;
+			}
+			return true;
+		}
+
+		void setDone(uint32_t id, bool isDone) {
+			if (id >= alive.size() || done[id] == isDone) {
+				return;
+			}
+			done[id] = isDone;
+			for (uint32_t blocked : successors[id]) {
+				if (isDone) {
+					openBlockers[blocked]--;
+				}
+				else {
+					openBlockers[blocked]++;
+				}
+			}
+		}
+
+		// Loads a whole graph at once with one topological sort (Kahn), which is cheaper
+		// than inserting the edges one by one. Edges that would close a cycle are skipped.
+		void build(const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+			std::vector<uint32_t> inDegree(alive.size(), 0);
+			std::vector<std::pair<uint32_t, uint32_t>> pending;
+			for (const std::pair<uint32_t, uint32_t>& edge : edges) {
+				if (edge.first < alive.size() && edge.second < alive.size() && alive[edge.first] && alive[edge.second]
+					&& edge.first != edge.second) {
+					successors[edge.first].push_back(edge.second);
+					predecessors[edge.second].push_back(edge.first);
+					inDegree[edge.second]++;
+				}
+			}
+
+			std::vector<uint32_t> sorted;
+			for (uint32_t node : order) {
+				if (inDegree[node] == 0) {
+					sorted.push_back(node);
+				}
+			}
+			for (size_t i = 0; i < sorted.size(); i++) {
+				for (uint32_t next : successors[sorted[i]]) {
+					if (--inDegree[next] == 0) {
+						sorted.push_back(next);
+					}
+				}
+			}
+			if (sorted.size() < order.size()) {
+				// Cycles in stored data: drop the edges into the unsorted nodes and retry them incrementally.
+				for (uint32_t node : order) {
+					if (inDegree[node] > 0) {
+						for (uint32_t blocker : predecessors[node]) {
+							eraseValue(successors[blocker], node);
+							pending.push_back({blocker, node});
+						}
+						predecessors[node].clear();
+						sorted.push_back(node);
+					}
+				}
+			}
+
+			order = sorted;
+			for (size_t i = 0; i < order.size(); i++) {
+				rank[order[i]] = static_cast<uint32_t>(i);
+			}
+			for (uint32_t node : order) {
+				openBlockers[node] = 0;
+				for (uint32_t blocker : predecessors[node]) {
+					openBlockers[node] += !done[blocker];
+				}
+			}
+			for (const std::pair<uint32_t, uint32_t>& edge : pending) {
+				addEdge(edge.first, edge.second);
+			}
+		}
+
+		bool isBlocked(uint32_t id) const {
+			return id < alive.size() && openBlockers[id] > 0;
+		}
+
+		// Unfinished tasks in a valid work order: every task comes after all its blockers.
+		std::vector<uint32_t> workOrder() const {
+			std::vector<uint32_t> nodes;
+			for (uint32_t node : order) {
+				if (alive[node] && !done[node]) {
+					nodes.push_back(node);
+				}
+			}
+			return nodes;
+		}
+
+		// The longest chain of unfinished tasks that block each other. Among equally long
+		// chains the one whose steps are due earliest wins. One pass over the topological order.
+		std::vector<uint32_t> criticalPath() const {
+			const uint32_t NONE = UINT32_MAX;
+			std::vector<uint32_t> length(alive.size(), 0);
+			std::vector<uint32_t> previous(alive.size(), NONE);
+			uint32_t last = NONE;
+
+			for (uint32_t node : order) {
+				if (!alive[node] || done[node]) {
+					continue;
+				}
+				length[node] = 1;
+				for (uint32_t blocker : predecessors[node]) {
+					if (done[blocker]) {
+						continue;
+					}
+					if (length[blocker] + 1 > length[node] ||
+						(length[blocker] + 1 == length[node] && dueDay[blocker] < dueDay[previous[node]])) {
+						length[node] = length[blocker] + 1;
+						previous[node] = blocker;
+					}
+				}
+				if (last == NONE || length[node] > length[last] ||
+					(length[node] == length[last] && dueDay[node] < dueDay[last])) {
+					last = node;
+				}
+			}
+
+			std::vector<uint32_t> path;
+			for (uint32_t node = last; node != NONE; node = previous[node]) {
+				path.push_back(node);
+			}
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+};
+
+// Compressed set of task ids in the style of Roaring bitmaps. Ids are split into
+// 65536-wide chunks; a chunk is a sorted array while it holds at most 4096 ids and a
+// plain 8 KiB bitmap above that. AND/OR/AND-NOT work chunk by chunk.
+class RoaringBitmap {
+	private:
+		static constexpr size_t ARRAY_LIMIT = 4096;
+		static constexpr size_t WORDS = 1024;
+
+		struct Container {
+			uint16_t key = 0;
+			uint32_t cardinality = 0;
+			std::vector<uint16_t> array;	// used while cardinality <= ARRAY_LIMIT
+			std::vector<uint64_t> bits;		// WORDS words, used above it
+
+			bool isBitmap() const { return !bits.empty(); }
+
+			bool contains(uint16_t low) const {
+				if (isBitmap()) {
+					return (bits[low >> 6] >> (low & 63)) & 1;
+				}
+				return std::binary_search(array.begin(), array.end(), low);
+			}
+
+			std::vector<uint64_t> asBits() const {
+				if (isBitmap()) {
+					return bits;
+				}
+				std::vector<uint64_t> words(WORDS, 0);
+				for (uint16_t low : array) {
+					words[low >> 6] |= uint64_t(1) << (low & 63);
+				}
+				return words;
+			}
+
+			// Picks the cheaper representation for the current cardinality.
+			void normalize() {
+				if (isBitmap() && cardinality <= ARRAY_LIMIT) {
+					array.clear();
+					for (size_t word = 0; word < WORDS; word++) {
+						for (uint64_t w = bits[word]; w != 0; w &= w - 1) {
+							array.push_back(static_cast<uint16_t>(word * 64 + __builtin_ctzll(w)));
+						}
+					}
+					bits.clear();
+					bits.shrink_to_fit();
+				}
+				else if (!isBitmap() && cardinality > ARRAY_LIMIT) {
+					bits = asBits();
+					array.clear();
+					array.shrink_to_fit();
+				}
+			}
+
+			static Container fromBits(uint16_t key, std::vector<uint64_t> words) {
+				Container result;
+				result.key = key;
+				for (uint64_t w : words) {
+					result.cardinality += __builtin_popcountll(w);
+				}
+				result.bits = std::move(words);
+				result.normalize();
+				return result;
+			}
+		};
+
+		enum class Operation {And, Or, AndNot};
+
+		std::vector<Container> containers;	// sorted by key, never empty
+
+		std::vector<Container>::iterator findContainer(uint16_t key) {
+			return std::lower_bound(containers.begin(), containers.end(), key,
+				[](const Container& c, uint16_t k) { return c.key < k; });
+		}
+
+		std::vector<Container>::const_iterator findContainer(uint16_t key) const {
+			return std::lower_bound(containers.begin(), containers.end(), key,
+				[](const Container& c, uint16_t k) { return c.key < k; });
+		}
+
+		static Container combine(const Container& a, const Container& b, Operation operation) {
+			Container result;
+			result.key = a.key;
+
+			if (!a.isBitmap() && !b.isBitmap()) {
+				std::vector<uint16_t>& out = result.array;
+				switch (operation) {
+					case Operation::And:
+						std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(out));
+						break;
+					case Operation::Or:
+						std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(out));
+						break;
+					case Operation::AndNot:
+						std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(out));
+						break;
+				}
+				result.cardinality = static_cast<uint32_t>(out.size());
+				result.normalize();
+				return result;
+			}
+
+			// Array filtered against a bitmap: no need to expand the array.
+			if (!a.isBitmap() && operation != Operation::Or) {
+				for (uint16_t low : a.array) {
+					if (b.contains(low) == (operation == Operation::And)) {
+						result.array.push_back(low);
+					}
+				}
+				result.cardinality = static_cast<uint32_t>(result.array.size());
+				return result;
+			}
+			if (!b.isBitmap() && operation == Operation::And) {
+				return combine(b, a, operation);
+			}
+
+			std::vector<uint64_t> words = a.asBits();
+			if (!b.isBitmap()) {
+				for (uint16_t low : b.array) {
+					uint64_t mask = uint64_t(1) << (low & 63);
+					if (operation == Operation::Or) {
+						words[low >> 6] |= mask;
+					}
+					else {
+						words[low >> 6] &= ~mask;
+					}
+				}
+			}
+			else {
+				for (size_t word = 0; word < WORDS; word++) {
+					switch (operation) {
+						case Operation::And: 	words[word] &= b.bits[word]; break;
+						case Operation::Or: 	words[word] |= b.bits[word]; break;
+						case Operation::AndNot: words[word] &= ~b.bits[word]; break;
+					}
+				}
+			}
+			return Container::fromBits(a.key, std::move(words));
+		}
+
+		static RoaringBitmap apply(const RoaringBitmap& a, const RoaringBitmap& b, Operation operation) {
+			RoaringBitmap result;
+			size_t i = 0, j = 0;
+			while (i < a.containers.size() || j < b.containers.size()) {
+				bool hasA = i < a.containers.size();
+				bool hasB = j < b.containers.size();
+				if (hasA && (!hasB || a.containers[i].key < b.containers[j].key)) {
+					if (operation != Operation::And) {
+						result.containers.push_back(a.containers[i]);
+					}
+					i++;
+				}
+				else if (hasB && (!hasA || b.containers[j].key < a.containers[i].key)) {
+					if (operation == Operation::Or) {
+						result.containers.push_back(b.containers[j]);
+					}
+					j++;
+				}
+				else {
+					Container combined = combine(a.containers[i], b.containers[j], operation);
+					if (combined.cardinality > 0) {
+						result.containers.push_back(std::move(combined));
+					}
+					i++;
+					j++;
+				}
+			}
+			return result;
+		}
+
+	public:
+		void add(uint32_t id) {
+			uint16_t key = static_cast<uint16_t>(id >> 16);
+			uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+			auto container = findContainer(key);
+			if (container == containers.end() || container->key != key) {
+				container = containers.insert(container, Container());
+				container->key = key;
+			}
+			if (container->isBitmap()) {
+				uint64_t& word = container->bits[low >> 6];
+				uint64_t mask = uint64_t(1) << (low & 63);
+				if (!(word & mask)) {
+					word |= mask;
+					container->cardinality++;
+				}
+				return;
+			}
+			auto slot = std::lower_bound(container->array.begin(), container->array.end(), low);
+			if (slot == container->array.end() || *slot != low) {
+				container->array.insert(slot, low);
+				container->cardinality++;
+				container->normalize();
+			}
+		}
+
+		void remove(uint32_t id) {
+			uint16_t key = static_cast<uint16_t>(id >> 16);
+			uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+			auto container = findContainer(key);
+			if (container == containers.end() || container->key != key || !container->contains(low)) {
+				return;
+			}
+			if (container->isBitmap()) {
+				container->bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+			}
+			else {
+				container->array.erase(std::lower_bound(container->array.begin(), container->array.end(), low));
+			}
+			container->cardinality--;
+			if (container->cardinality == 0) {
+				containers.erase(container);
+			}
+			else {
+				container->normalize();
+			}
+		}
+
+		bool contains(uint32_t id) const {
+			uint16_t key = static_cast<uint16_t>(id >> 16);
+			auto container = findContainer(key);
+			return container != containers.end() && container->key == key && container->contains(static_cast<uint16_t>(id & 0xFFFF));
+		}
+
+		size_t cardinality() const {
+			size_t count = 0;
+			for (const Container& container : containers) {
+				count += container.cardinality;
+			}
+			return count;
+		}
+
+		void clear() { containers.clear(); }
+
+		RoaringBitmap operator&(const RoaringBitmap& other) const { return apply(*this, other, Operation::And); }
+		RoaringBitmap operator|(const RoaringBitmap& other) const { return apply(*this, other, Operation::Or); }
+		RoaringBitmap operator-(const RoaringBitmap& other) const { return apply(*this, other, Operation::AndNot); }
+
+		std::vector<uint32_t> toVector() const {
+			std::vector<uint32_t> ids;
+			ids.reserve(cardinality());
+			for (const Container& container : containers) {
+				uint32_t high = static_cast<uint32_t>(container.key) << 16;
+				if (container.isBitmap()) {
+					for (size_t word = 0; word < WORDS; word++) {
+						for (uint64_t w = container.bits[word]; w != 0; w &= w - 1) {
+							ids.push_back(high | static_cast<uint32_t>(word * 64 + __builtin_ctzll(w)));
+						}
+					}
+				}
+				else {
+					for (uint16_t low : container.array) {
+						ids.push_back(high | low);
+					}
+				}
+			}
+			return ids;
+		}
+};
+
+// Evaluates tag expressions such as "urgent AND backend AND NOT waiting" on the tag
+// bitmaps. NOT binds tighter than AND, AND tighter than OR; parentheses group.
+// Unknown tags match no task.
+class TagQuery {
+	private:
+		const std::unordered_map<std::string, RoaringBitmap>& postings;
+		const RoaringBitmap& allTasks;
+		std::vector<std::string> tokens;
+		size_t next = 0;
+
+		static std::string lower(std::string text) {
+			std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+			return text;
+		}
+
+		bool accept(const std::string& keyword) {
+			if (next < tokens.size() && lower(tokens[next]) == keyword) {
+				next++;
+				return true;
+			}
+			return false;
+		}
+
+		RoaringBitmap parseOr() {
+			RoaringBitmap result = parseAnd();
+			while (accept("or")) {
+				result = result | parseAnd();
+			}
+			return result;
+		}
+
+		RoaringBitmap parseAnd() {
+			RoaringBitmap result = parseNot();
+			while (accept("and")) {
+				result = result & parseNot();
+			}
+			return result;
+		}
+
+		RoaringBitmap parseNot() {
+			if (accept("not")) {
+				return allTasks - parseNot();
+			}
+			if (accept("(")) {
+				RoaringBitmap result = parseOr();
+				if (!accept(")")) {
+					throw std::invalid_argument("\033[31mMissing ')' in tag filter.\033[0m");
+				}
+				return result;
+			}
+			if (next >= tokens.size() || tokens[next] == ")") {
+				throw std::invalid_argument("\033[31mTag expected in tag filter.\033[0m");
+			}
+			auto found = postings.find(lower(tokens[next++]));
+			return found == postings.end() ? RoaringBitmap() : found->second;
+		}
+
+	public:
+		TagQuery(const std::string& expression, const std::unordered_map<std::string, RoaringBitmap>& postings,
+			const RoaringBitmap& allTasks)
+			: postings(postings), allTasks(allTasks)
+		{
+			std::string token;
+			for (char c : expression) {
+				if (std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')') {
+					if (!token.empty()) {
+						tokens.push_back(token);
+						token.clear();
+					}
+					if (c == '(' || c == ')') {
+						tokens.push_back(std::string(1, c));
+					}
+				}
+				else {
+					token += c;
+				}
+			}
+			if (!token.empty()) {
+				tokens.push_back(token);
+			}
+		}
+
+		// Tags a filter can name: no whitespace or parentheses, and not one of the operators.
+		static bool isValidTag(const std::string& tag) {
+			if (tag.empty()) {
+				return false;
+			}
+			for (char c : tag) {
+				if (std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')') {
+					return false;
+				}
+			}
+			std::string name = lower(tag);
+			return name != "and" && name != "or" && name != "not";
+		}
+
+		RoaringBitmap evaluate() {
+			RoaringBitmap result = parseOr();
+			if (next != tokens.size()) {
+				throw std::invalid_argument("\033[31mInvalid tag filter near:\033[0m " + tokens[next]);
+			}
+			return result;
+		}
+};
+
+// Named trade-offs between durability and speed. InMemory keeps the whole database
+// in RAM and writes it to its file with the sqlite3 backup API. It is for a single
+// process: it never sees writes of others, and its saves overwrite them.
+enum class StorageProfile {Durable, Balanced, Fast, InMemory};
+
+struct StorageSettings {
+	const char* journalMode;
+	const char* synchronous;
+	int cacheSize;			// PRAGMA cache_size, negative values are KiB
+	long long mmapSize;		// bytes
+	const char* tempStore;
+};
+
+StorageSettings storageSettings(StorageProfile profile) {
+	switch (profile) {
+		case StorageProfile::Durable:  return {"DELETE", "FULL", -2000, 0, "DEFAULT"};
+		case StorageProfile::Balanced: return {"WAL", "NORMAL", -16000, 64ll << 20, "MEMORY"};
+		case StorageProfile::Fast: 	   return {"WAL", "OFF", -64000, 256ll << 20, "MEMORY"};
+		case StorageProfile::InMemory: return {"MEMORY", "OFF", -64000, 0, "MEMORY"};
+	}
+	throw std::invalid_argument("\033[31mInvalid Storage Profile.\033[0m");
+}
+
+
+// Scope of one local write. The data change and its table_versions bump commit together,
+// so a write costs one commit and other processes never see the data without the counter.
+// A write made while another one is open (e.g. addTask from updateStatus) joins it.
+// Rolls back unless commit() was called. If the write lock cannot be taken, ok() is false
+// and the write must not run: outside a transaction it would commit without its bump.
+class WriteTransaction {
+	private:
+		sqlite3* db;
+		bool open;
+		std::string failure;
+
+	public:
+		explicit WriteTransaction(sqlite3* connection)
+			: db(connection), open(sqlite3_get_autocommit(connection) != 0)
+		{
+			if (open && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+				failure = sqlite3_errmsg(db);
+				open = false;
+			}
+		}
+
+		~WriteTransaction() {
+			if (open) {
+				sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+			}
+		}
+
+		WriteTransaction(const WriteTransaction&) = delete;
+		WriteTransaction& operator=(const WriteTransaction&) = delete;
+
+		bool ok() const { return failure.empty(); }
+
+		// Returns false if the COMMIT failed, e.g. with SQLITE_BUSY while another process still
+		// reads; everything is rolled back then. A joined write leaves that to the outer one.
+		bool commit() {
+			if (!open) {
+				return true;
+			}
+			open = false;
+			if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+				return true;
+			}
+			failure = sqlite3_errmsg(db);
+			sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+			return false;
+		}
+
+		// Why BEGIN or COMMIT failed.
+		const std::string& error() const { return failure; }
+
+		void rollback() {
+			if (open) {
+				sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+				open = false;
+			}
+		}
+};
+
+
+std::string PrioToStr(const Priority& prio);
+std::string StatToStr(const Status& stat);
+
+class TaskManager {
+	private:
+		sqlite3* db;
+		static constexpr int BUSY_TIMEOUT_MS = 5000;
+
+		// Only set for StorageProfile::InMemory: the file the in-memory database is saved to.
+		std::string persistPath;
+		std::chrono::seconds persistInterval;
+		mutable std::chrono::steady_clock::time_point lastPersist;
+
+		// Open and in-progress tasks ranked for "Next tasks". Loaded on first use and then
+		// kept up to date by addTask, removeTask, updateStatus and updatePriority.
+		AgendaScore agendaScore;
+		AgendaHeap agenda;
+		bool agendaLoaded = false;
+
+		// Caches that other processes can make stale. refreshIfChanged() notices their
+		// writes through PRAGMA data_version and the per-table counters in table_versions,
+		// and drops only the state built from the tables that changed.
+		static constexpr size_t LOOKUP_CACHE_LIMIT = 4096;
+		mutable std::unordered_map<std::string, std::optional<Task>> lookupCache;
+		mutable std::optional<std::vector<std::string>> cachedCategories;
+		mutable std::optional<std::vector<std::string>> cachedPriorities;
+		mutable std::optional<std::vector<std::string>> cachedStatuses;
+		uint64_t generation = 0;
+		long long dataVersion = 0;
+		std::unordered_map<std::string, long long> seenVersions;
+
+		long long readDataVersion() const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				PRAGMA data_version;
+				)", -1, &stmt, nullptr);
+
+			long long version = 0;
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				version = sqlite3_column_int64(stmt, 0);
+			}
+
+			sqlite3_finalize(stmt);
+			return version;
+		}
+
+		std::unordered_map<std::string, long long> readTableVersions() const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT name, version FROM table_versions;
+				)", -1, &stmt, nullptr);
+
+			std::unordered_map<std::string, long long> versions;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				versions[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))] = sqlite3_column_int64(stmt, 1);
+			}
+
+			sqlite3_finalize(stmt);
+			return versions;
+		}
+
+		// Tells other processes that 'table' changed. If nobody else bumped the counter in
+		// the meantime our own write is already reflected in memory, so it is marked as seen.
+		void bumpVersion(const std::string& table) {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				UPDATE table_versions SET version = version + 1 WHERE name = ? RETURNING version;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_STATIC);
+
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				long long version = sqlite3_column_int64(stmt, 0);
+				if (version == seenVersions[table] + 1) {
+					seenVersions[table] = version;
+				}
+			}
+
+			sqlite3_finalize(stmt);
+		}
+
+		// Drops the caches built from the tasks table after a local write. 'title' limits
+		// the lookup cache eviction to one task; std::nullopt clears it.
+		void tasksWritten(const std::optional<std::string>& title) {
+			if (title) {
+				lookupCache.erase(*title);
+			}
+			else {
+				lookupCache.clear();
+			}
+			cachedCategories.reset();
+			cachedPriorities.reset();
+			cachedStatuses.reset();
+			generation++;
+			bumpVersion("tasks");
+		}
+
+		// Recurring task rules. Their occurrences inside the recurrence window are listed
+		// next to the stored tasks without being stored; an occurrence only becomes a row in
+		// tasks once its status or priority is changed. Removed occurrences are remembered
+		// in recurrence_skips so they do not come back.
+		static constexpr long long RECURRENCE_LOOKBACK_DAYS = 7;
+		static constexpr long long RECURRENCE_LOOKAHEAD_DAYS = 28;
+		mutable std::vector<RecurrenceRule> rules;
+		mutable bool rulesLoaded = false;
+		std::optional<std::pair<long long, long long>> recurrenceWindow;
+
+		const std::vector<RecurrenceRule>& loadedRules() const {
+			if (rulesLoaded) {
+				return rules;
+			}
+			rules.clear();
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT title, category, priority, kind, every, startDate, endDate FROM recurrences ORDER BY title;
+				)", -1, &stmt, nullptr);
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				RecurrenceRule rule;
+				rule.title 		= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				rule.category 	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				rule.priority 	= static_cast<Priority>(sqlite3_column_int(stmt, 2));
+				rule.repeat 	= static_cast<Repeat>(sqlite3_column_int(stmt, 3));
+				rule.every 		= sqlite3_column_int(stmt, 4);
+				rule.startDate 	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+				if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) {
+					rule.endDate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+				}
+				// Rules stored before dates were checked could not be expanded.
+				if (!isValidDate(rule.startDate) || (rule.endDate && !isValidDate(*rule.endDate))) {
+					continue;
+				}
+				rules.push_back(rule);
+			}
+
+			sqlite3_finalize(stmt);
+			rulesLoaded = true;
+			return rules;
+		}
+
+		std::pair<long long, long long> currentWindow() const {
+			if (recurrenceWindow) {
+				return *recurrenceWindow;
+			}
+			long long today = todayDays();
+			return {today - RECURRENCE_LOOKBACK_DAYS, today + RECURRENCE_LOOKAHEAD_DAYS};
+		}
+
+		// Titles of the occurrences of 'rule' that are stored as tasks or were removed.
+		std::unordered_set<std::string> settledOccurrences(const RecurrenceRule& rule) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT title FROM tasks WHERE title >= ? AND title < ?
+				UNION ALL
+				SELECT occurrence FROM recurrence_skips WHERE rule = ?;
+				)", -1, &stmt, nullptr);
+
+			// A title range instead of a prefix match, so the primary key index is used.
+			const std::string first = rule.title + " @ ";
+			const std::string last = rule.title + " @!";
+			sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, last.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, rule.title.c_str(), -1, SQLITE_STATIC);
+
+			std::unordered_set<std::string> settled;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				settled.insert(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+			}
+
+			sqlite3_finalize(stmt);
+			return settled;
+		}
+
+		// Unsettled occurrences in the recurrence window that 'keep' accepts. Only the
+		// dates inside the window are computed, so this costs O(rules + occurrences shown).
+		template <typename Keep>
+		std::vector<Task> occurrencesWhere(Keep keep) const {
+			const std::pair<long long, long long> window = currentWindow();
+			std::vector<Task> occurrences;
+			for (const RecurrenceRule& rule : loadedRules()) {
+				Task probe(rule.title, rule.category, rule.startDate, rule.priority, Status::Open);
+				if (!keep(probe)) {
+					continue;
+				}
+				std::vector<long long> days = rule.occurrences(window.first, window.second);
+				if (days.empty()) {
+					continue;
+				}
+				std::unordered_set<std::string> settled = settledOccurrences(rule);
+				for (long long day : days) {
+					std::string title = rule.occurrenceTitle(day);
+					if (settled.count(title) == 0) {
+						occurrences.push_back(Task(title, rule.category, daysToDate(day), rule.priority, Status::Open));
+					}
+				}
+			}
+			return occurrences;
+		}
+
+		std::vector<Task> expandOccurrences() const {
+			return occurrencesWhere([](const Task&) { return true; });
+		}
+
+		// The rule and due day 'title' is an occurrence of, if it is one.
+		std::optional<std::pair<RecurrenceRule, long long>> parseOccurrence(const std::string& title) const {
+			const size_t separator = title.rfind(" @ ");
+			if (separator == std::string::npos || title.size() != separator + 3 + 10) {
+				return std::nullopt;
+			}
+			const std::string ruleTitle = title.substr(0, separator);
+			long long day;
+			try {
+				day = dateToDays(title.substr(separator + 3));
+			}
+			catch (const std::logic_error&) {
+				return std::nullopt;
+			}
+			for (const RecurrenceRule& rule : loadedRules()) {
+				if (rule.title == ruleTitle && !rule.occurrences(day, day).empty() && rule.occurrenceTitle(day) == title) {
+					return std::make_pair(rule, day);
+				}
+			}
+			return std::nullopt;
+		}
+
+		bool isSkipped(const std::string& occurrence) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT 1 FROM recurrence_skips WHERE occurrence = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, occurrence.c_str(), -1, SQLITE_STATIC);
+
+			bool skipped = sqlite3_step(stmt) == SQLITE_ROW;
+			sqlite3_finalize(stmt);
+			return skipped;
+		}
+
+		// Stores an occurrence that is not a task yet, so it can be edited like one.
+		bool materialize(const std::string& title) {
+			std::optional<std::pair<RecurrenceRule, long long>> occurrence = parseOccurrence(title);
+			if (!occurrence || isSkipped(title)) {
+				return false;
+			}
+			const RecurrenceRule& rule = occurrence->first;
+			return addTask(Task(title, rule.category, daysToDate(occurrence->second), rule.priority, Status::Open));
+		}
+
+		void rulesWritten() {
+			rulesLoaded = false;
+			tasksWritten(std::nullopt);
+		}
+
+		static bool titleBefore(const TaskRecord& a, const TaskRecord& b) { return a.title < b.title; }
+		static bool categoryBefore(const TaskRecord& a, const TaskRecord& b) { return a.category < b.category; }
+		static bool priorityBefore(const TaskRecord& a, const TaskRecord& b) { return a.priority > b.priority; }
+		static bool statusBefore(const TaskRecord& a, const TaskRecord& b) { return a.status < b.status; }
+
+		// Merges the occurrences into 'tasks', which is already sorted by 'less'.
+		template <typename Less>
+		void mergeOccurrences(std::vector<Task>& tasks, Less less) const {
+			std::vector<Task> occurrences = expandOccurrences();
+			auto before = [less](const Task& a, const Task& b) { return less(TaskRecord::of(a), TaskRecord::of(b)); };
+			std::stable_sort(occurrences.begin(), occurrences.end(), before);
+
+			const size_t stored = tasks.size();
+			tasks.insert(tasks.end(), std::make_move_iterator(occurrences.begin()), std::make_move_iterator(occurrences.end()));
+			std::inplace_merge(tasks.begin(), tasks.begin() + stored, tasks.end(), before);
+		}
+
+		// Appends the rows of 'stmt', which come sorted by 'less', merged with the occurrences.
+		template <typename Less>
+		void appendSorted(sqlite3_stmt* stmt, Less less, TaskBatch& batch) const {
+			std::vector<Task> occurrences = expandOccurrences();
+			auto before = [less](const Task& a, const Task& b) { return less(TaskRecord::of(a), TaskRecord::of(b)); };
+			std::stable_sort(occurrences.begin(), occurrences.end(), before);
+
+			size_t next = 0;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				TaskRecord row = TaskRecord::ofRow(stmt);
+				while (next < occurrences.size() && less(TaskRecord::of(occurrences[next]), row)) {
+					batch.append(TaskRecord::of(occurrences[next++]));
+				}
+				batch.append(row);
+			}
+			while (next < occurrences.size()) {
+				batch.append(TaskRecord::of(occurrences[next++]));
+			}
+		}
+
+		// Dense task ids with the dependency graph and the tag bitmaps built on them. Loaded
+		// on first use, then kept up to date by addTask, removeTask, updateStatus and the
+		// dependency and tag methods.
+		TaskIndex taskIndex;
+		DependencyGraph dependencies;
+		std::unordered_map<std::string, RoaringBitmap> tagPostings;
+		RoaringBitmap allTaskIds;
+		bool taskIndexLoaded = false;
+
+		void loadTaskIndex() {
+			taskIndex.clear();
+			dependencies.clear();
+			tagPostings.clear();
+			allTaskIds.clear();
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT title, dueDate, status FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string dueDate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				Status status 		= static_cast<Status>(sqlite3_column_int(stmt, 2));
+				uint32_t id = taskIndex.intern(title);
+				dependencies.addNode(id, dateToDays(dueDate), status == Status::Done);
+				allTaskIds.add(id);
+			}
+			sqlite3_finalize(stmt);
+
+			sqlite3_prepare_v2(db, R"(
+				SELECT blocker, blocked FROM dependencies;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::pair<uint32_t, uint32_t>> edges;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::optional<uint32_t> blocker = taskIndex.find(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+				std::optional<uint32_t> blocked = taskIndex.find(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+				if (blocker && blocked) {
+					edges.push_back({*blocker, *blocked});
+				}
+			}
+			sqlite3_finalize(stmt);
+
+			dependencies.build(edges);
+
+			sqlite3_prepare_v2(db, R"(
+				SELECT task_tags.title, tags.name FROM task_tags JOIN tags ON tags.id = task_tags.tag;
+				)", -1, &stmt, nullptr);
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::optional<uint32_t> id = taskIndex.find(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+				if (id) {
+					tagPostings[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))].add(*id);
+				}
+			}
+			sqlite3_finalize(stmt);
+
+			taskIndexLoaded = true;
+		}
+
+		// Looks up the tasks for task ids, keeping the order of 'ids'. Few ids are looked up
+		// one by one, many with a single table scan that only copies the rows it keeps.
+		std::vector<Task> tasksForIds(const std::vector<uint32_t>& ids) const {
+			if (ids.size() * 16 < taskIndex.size()) {
+				std::vector<Task> tasks;
+				for (uint32_t id : ids) {
+					std::optional<Task> task = findTask(taskIndex.title(id));
+					if (task != std::nullopt) {
+						tasks.push_back(*task);
+					}
+				}
+				return tasks;
+			}
+
+			const size_t NONE = SIZE_MAX;
+			std::vector<size_t> slot(taskIndex.size(), NONE);
+			for (size_t i = 0; i < ids.size(); i++) {
+				slot[ids[i]] = i;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::optional<Task>> found(ids.size());
+			std::string title;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				TaskRecord row = TaskRecord::ofRow(stmt);
+				title.assign(row.title);
+				std::optional<uint32_t> id = taskIndex.find(title);
+				if (id && slot[*id] != NONE) {
+					found[slot[*id]] = row.toTask();
+				}
+			}
+
+			sqlite3_finalize(stmt);
+
+			std::vector<Task> tasks;
+			tasks.reserve(ids.size());
+			for (std::optional<Task>& task : found) {
+				if (task != std::nullopt) {
+					tasks.push_back(std::move(*task));
+				}
+			}
+			return tasks;
+		}
+
+		void loadAgenda() {
+			agenda.clear();
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT title, dueDate, priority FROM tasks WHERE status != ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(Status::Done));
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string dueDate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				Priority priority 	= static_cast<Priority>(sqlite3_column_int(stmt, 2));
+				agenda.upsert(title, agendaScore(dueDate, priority));
+			}
+
+			sqlite3_finalize(stmt);
+			agendaLoaded = true;
+		}
+
+		// Copies the whole database. While another connection holds a lock the copy is
+		// retried for up to COPY_TIMEOUT_MS; it only succeeds if every page was copied.
+		static bool copyDatabase(sqlite3* from, sqlite3* to) {
+			const int COPY_TIMEOUT_MS = 5000;
+			const int RETRY_MS = 50;
+
+			sqlite3_backup* backup = sqlite3_backup_init(to, "main", from, "main");
+			if (backup == nullptr) {
+				return false;
+			}
+			int result = sqlite3_backup_step(backup, -1);
+			for (int waited = 0; (result == SQLITE_BUSY || result == SQLITE_LOCKED) && waited < COPY_TIMEOUT_MS; waited += RETRY_MS) {
+				sqlite3_sleep(RETRY_MS);
+				result = sqlite3_backup_step(backup, -1);
+			}
+			return sqlite3_backup_finish(backup) == SQLITE_OK && result == SQLITE_DONE;
+		}
+
+		// Warns if a setting is not in effect. journal_mode returns the mode it ends up in: the
+		// switch is refused while another connection uses the file in a different mode.
+		void applyProfile(StorageProfile profile) {
+			StorageSettings settings = storageSettings(profile);
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, (std::string("PRAGMA journal_mode = ") + settings.journalMode + ";").c_str(), -1, &stmt, nullptr);
+
+			std::string journalMode;
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				journalMode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::transform(journalMode.begin(), journalMode.end(), journalMode.begin(), ::toupper);
+			}
+			else {
+				journalMode = std::string("unchanged, ") + sqlite3_errmsg(db);
+			}
+			sqlite3_finalize(stmt);
+
+			if (journalMode != settings.journalMode) {
+				std::cerr << "\033[31mCould not set journal_mode to " << settings.journalMode << " (database in use by another process?):\033[0m "
+					<< journalMode << std::endl;
+			}
+
+			std::string pragmas =
+				std::string("PRAGMA synchronous = ") + settings.synchronous + ";" +
+				"PRAGMA cache_size = " + std::to_string(settings.cacheSize) + ";" +
+				"PRAGMA mmap_size = " + std::to_string(settings.mmapSize) + ";" +
+				"PRAGMA temp_store = " + settings.tempStore + ";";
+			if (sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+				std::cerr << "\033[31mCould not apply the storage profile:\033[0m " << sqlite3_errmsg(db) << std::endl;
+			}
+		}
+
+		// Called after every write. Saves an in-memory database once the persist interval has passed.
+		void persistIfDue() const {
+			if (persistPath.empty() || persistInterval.count() <= 0) {
+				return;
+			}
+			if (std::chrono::steady_clock::now() - lastPersist >= persistInterval) {
+				persist();
+			}
+		}
+
+		// Dates are stored as DD-MM-YYYY (with any separator), so they are rearranged
+		// to YYYYMMDD before comparing.
+		static std::string sortableDate(const std::string& date) {
+			return date.substr(6, 4) + date.substr(3, 2) + date.substr(0, 2);
+		}
+
+		// 'extra' is one more condition, e.g. to leave out rows that already have the new value.
+		static std::string whereClause(const TaskFilter& filter, const std::string& extra = "") {
+			std::vector<std::string> conditions;
+			if (filter.category) { conditions.push_back("category = ?"); }
+			if (filter.priority) { conditions.push_back("priority = ?"); }
+			if (filter.status) 	 { conditions.push_back("status = ?"); }
+			if (filter.dueBefore) {
+				conditions.push_back("substr(dueDate, 7, 4) || substr(dueDate, 4, 2) || substr(dueDate, 1, 2) < ?");
+			}
+			if (!extra.empty()) {
+				conditions.push_back(extra);
+			}
+
+			std::string clause;
+			for (size_t i = 0; i < conditions.size(); i++) {
+				clause += (i == 0 ? " WHERE " : " AND ") + conditions[i];
+			}
+			return clause;
+		}
+
+		// Binds the filter values in the order whereClause emits them, starting at 'index'.
+		static void bindFilter(sqlite3_stmt* stmt, const TaskFilter& filter, int index) {
+			if (filter.category) { sqlite3_bind_text(stmt, index++, filter.category->c_str(), -1, SQLITE_TRANSIENT); }
+			if (filter.priority) { sqlite3_bind_int(stmt, index++, static_cast<int>(*filter.priority)); }
+			if (filter.status) 	 { sqlite3_bind_int(stmt, index++, static_cast<int>(*filter.status)); }
+			if (filter.dueBefore) {
+				sqlite3_bind_text(stmt, index++, sortableDate(*filter.dueBefore).c_str(), -1, SQLITE_TRANSIENT);
+			}
+		}
+
+		// A rolled back write may already have updated the caches and marked its version
+		// bumps as seen, so start over.
+		void rolledBack() {
+			rulesLoaded = false;
+			lookupCache.clear();
+			cachedCategories.reset();
+			cachedPriorities.reset();
+			cachedStatuses.reset();
+			generation++;
+			agendaLoaded = false;
+			taskIndexLoaded = false;
+			seenVersions = readTableVersions();
+		}
+
+		void writeFailed(const WriteTransaction& transaction) {
+			std::cout << "\n\033[31mCould not save the change: " << transaction.error() << "\033[0m" << std::endl;
+			rolledBack();
+		}
+
+		static bool matchesFilter(const Task& task, const TaskFilter& filter) {
+			return (!filter.category || task.getCategory() == *filter.category)
+				&& (!filter.priority || task.getPriority() == *filter.priority)
+				&& (!filter.status || task.getStatus() == *filter.status)
+				&& (!filter.dueBefore || sortableDate(task.getDueDate()) < sortableDate(*filter.dueBefore));
+		}
+
+		// Unstored occurrences in the recurrence window that a bulk statement with 'filter' would
+		// affect if they were rows: updates store them first, removals skip them. 'changes' leaves
+		// out occurrences an update would not change.
+		enum class OccurrenceAction {Store, Skip};
+
+		// Returns the number of occurrences that were skipped without being stored.
+		size_t applyToOccurrences(const TaskFilter& filter, OccurrenceAction action, const std::function<bool(const Task&)>& changes) {
+			size_t skipped = 0;
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT OR IGNORE INTO recurrence_skips (occurrence, rule) VALUES (?, ?);
+				)", -1, &stmt, nullptr);
+
+			auto skip = [this, stmt](const std::string& title, const std::string& rule) {
+				sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_TRANSIENT);
+				sqlite3_bind_text(stmt, 2, rule.c_str(), -1, SQLITE_TRANSIENT);
+				bool inserted = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
+				sqlite3_reset(stmt);
+				return inserted;
+			};
+
+			for (const Task& occurrence : expandOccurrences()) {
+				if (!matchesFilter(occurrence, filter) || !changes(occurrence)) {
+					continue;
+				}
+				if (action == OccurrenceAction::Store) {
+					addTask(occurrence);
+				}
+				else if (std::optional<std::pair<RecurrenceRule, long long>> parsed = parseOccurrence(occurrence.getTitle())) {
+					skipped += skip(occurrence.getTitle(), parsed->first.title);
+				}
+			}
+
+			// Stored occurrences that are about to be deleted must not come back either.
+			if (action == OccurrenceAction::Skip) {
+				sqlite3_stmt* select;
+				sqlite3_prepare_v2(db, ("SELECT title FROM tasks" + whereClause(filter) + ";").c_str(), -1, &select, nullptr);
+				bindFilter(select, filter, 1);
+
+				std::vector<std::string> titles;
+				while (sqlite3_step(select) == SQLITE_ROW) {
+					titles.push_back(reinterpret_cast<const char*>(sqlite3_column_text(select, 0)));
+				}
+				sqlite3_finalize(select);
+
+				for (const std::string& title : titles) {
+					if (std::optional<std::pair<RecurrenceRule, long long>> parsed = parseOccurrence(title)) {
+						skip(title, parsed->first.title);
+					}
+				}
+			}
+
+			sqlite3_finalize(stmt);
+			return skipped;
+		}
+
+		// Runs one UPDATE/DELETE in its own transaction and returns the number of changed rows,
+		// including the recurring task occurrences it applied to.
+		size_t runBulk(const std::string& sql, const TaskFilter& filter, std::optional<int> value, OccurrenceAction occurrences,
+			const std::function<bool(const Task&)>& changes) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return 0;
+			}
+			size_t skipped = applyToOccurrences(filter, occurrences, changes);
+
+			sqlite3_stmt* stmt;
+			if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+				transaction.rollback();
+				rolledBack();
+				return 0;
+			}
+
+			int index = 1;
+			if (value) {
+				sqlite3_bind_int(stmt, index++, *value);
+			}
+			bindFilter(stmt, filter, index);
+
+			int result = sqlite3_step(stmt);
+			size_t changed = static_cast<size_t>(sqlite3_changes(db)) + skipped;
+			sqlite3_finalize(stmt);
+
+			if (result != SQLITE_DONE) {
+				transaction.rollback();
+				rolledBack();
+				return 0;
+			}
+			tasksWritten(std::nullopt);
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return 0;
+			}
+			persistIfDue();
+			agendaLoaded = false;
+			taskIndexLoaded = false;
+			return changed;
+		}
+
+	public:
+		// With StorageProfile::InMemory the database at 'path' is loaded into RAM and saved back
+		// every 'persistSeconds' (checked on writes; 0 = only at exit) and when the TaskManager is destroyed.
+		// Throws if the file exists but cannot be loaded, e.g. because another process keeps it locked.
+		explicit TaskManager(const std::string& path = "./data/tasks_sql.db", StorageProfile profile = StorageProfile::Durable,
+			int persistSeconds = 0)
+			: persistPath(profile == StorageProfile::InMemory ? path : ""), persistInterval(persistSeconds),
+			lastPersist(std::chrono::steady_clock::now())
+		{
+			const std::string openPath = persistPath.empty() ? path : ":memory:";
+			if (sqlite3_open(openPath.c_str(), &db) != SQLITE_OK) {
+				std::string errorMsg = sqlite3_errmsg(db);
+				sqlite3_close(db);
+				throw std::runtime_error("Failed to open database: " + errorMsg);
+			}
+			// Other processes lock the file while they write (or, without WAL, read),
+			// so wait for them instead of failing at once.
+			sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+
+			// An existing file that cannot be loaded must not be replaced by an empty
+			// database on the next persist(), so that is an error.
+			if (!persistPath.empty()) {
+				sqlite3* file;
+				bool exists = sqlite3_open_v2(persistPath.c_str(), &file, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK;
+				bool loaded = exists && copyDatabase(file, db);
+				sqlite3_close(file);
+				if (exists && !loaded) {
+					sqlite3_close(db);
+					throw std::runtime_error("Failed to load database into memory (locked by another process?): " + persistPath);
+				}
+			}
+			applyProfile(profile);
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				CREATE TABLE IF NOT EXISTS tasks (
+					title 		TEXT		PRIMARY KEY,
+					category	TEXT		NOT NULL,
+					dueDate		TEXT		NOT NULL,
+					priority	INTEGER		NOT NULL,
+					status		INTEGER		NOT NULL
+					);
+				)", -1, &stmt, nullptr);
+				
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+
+			// "blocker has to be done before blocked" and the labels of a task. Removing a
+			// task removes its edges and labels.
+			sqlite3_exec(db, R"(
+				PRAGMA foreign_keys = ON;
+				CREATE TABLE IF NOT EXISTS dependencies (
+					blocker		TEXT		NOT NULL REFERENCES tasks(title) ON DELETE CASCADE,
+					blocked		TEXT		NOT NULL REFERENCES tasks(title) ON DELETE CASCADE,
+					PRIMARY KEY (blocker, blocked)
+					);
+				CREATE INDEX IF NOT EXISTS dependencies_blocked ON dependencies(blocked);
+				CREATE TABLE IF NOT EXISTS tags (
+					id			INTEGER		PRIMARY KEY,
+					name		TEXT		NOT NULL UNIQUE
+					);
+				CREATE TABLE IF NOT EXISTS task_tags (
+					title		TEXT		NOT NULL REFERENCES tasks(title) ON DELETE CASCADE,
+					tag			INTEGER		NOT NULL REFERENCES tags(id) ON DELETE CASCADE,
+					PRIMARY KEY (title, tag)
+					);
+				CREATE INDEX IF NOT EXISTS task_tags_tag ON task_tags(tag);
+				CREATE TABLE IF NOT EXISTS table_versions (
+					name		TEXT		PRIMARY KEY,
+					version		INTEGER		NOT NULL
+					);
+				INSERT OR IGNORE INTO table_versions (name, version) VALUES ('tasks', 0), ('dependencies', 0), ('tags', 0);
+				)", nullptr, nullptr, nullptr);
+
+			// Recurring task rules (kind is a Repeat) and the occurrences removed from them.
+			// Rule changes count as writes to 'tasks' since they change what is listed.
+			sqlite3_exec(db, R"(
+				CREATE TABLE IF NOT EXISTS recurrences (
+					title		TEXT		PRIMARY KEY,
+					category	TEXT		NOT NULL,
+					priority	INTEGER		NOT NULL,
+					kind		INTEGER		NOT NULL,
+					every		INTEGER		NOT NULL,
+					startDate	TEXT		NOT NULL,
+					endDate		TEXT
+					);
+				CREATE TABLE IF NOT EXISTS recurrence_skips (
+					occurrence	TEXT		PRIMARY KEY,
+					rule		TEXT		NOT NULL REFERENCES recurrences(title) ON DELETE CASCADE
+					);
+				CREATE INDEX IF NOT EXISTS recurrence_skips_rule ON recurrence_skips(rule);
+				)", nullptr, nullptr, nullptr);
+
+			dataVersion = readDataVersion();
+			seenVersions = readTableVersions();
+		};
+
+		~TaskManager() {
+			persist();
+			sqlite3_close(db);
+		}
+
+		// Checks whether another process wrote to the database since the last call and
+		// drops the in-memory state built from the tables it changed. Cheap enough to call
+		// before every menu iteration. Writers that do not update table_versions (e.g. the
+		// sqlite3 shell) are detected too, but then everything is dropped.
+		bool refreshIfChanged() {
+			long long version = readDataVersion();
+			if (version == dataVersion) {
+				return false;
+			}
+			dataVersion = version;
+
+			std::unordered_map<std::string, long long> versions = readTableVersions();
+			bool tasksChanged = versions["tasks"] != seenVersions["tasks"];
+			bool graphChanged = versions["dependencies"] != seenVersions["dependencies"];
+			bool tagsChanged = versions["tags"] != seenVersions["tags"];
+			if (!tasksChanged && !graphChanged && !tagsChanged) {
+				tasksChanged = true;
+			}
+			seenVersions = versions;
+
+			if (tasksChanged) {
+				lookupCache.clear();
+				cachedCategories.reset();
+				cachedPriorities.reset();
+				cachedStatuses.reset();
+				generation++;
+				agendaLoaded = false;
+				rulesLoaded = false;
+			}
+			if (tasksChanged || graphChanged || tagsChanged) {
+				taskIndexLoaded = false;
+			}
+			return true;
+		}
+
+		// Changes whenever the tasks table changed, locally or in another process.
+		uint64_t getGeneration() const { return generation; }
+
+		// Saves an in-memory database to its file. Does nothing for file-backed profiles.
+		// Returns false if the file could not be written; persistIfDue then tries again on the next write.
+		bool persist() const {
+			if (persistPath.empty()) {
+				return true;
+			}
+			sqlite3* file;
+			bool saved = sqlite3_open(persistPath.c_str(), &file) == SQLITE_OK && copyDatabase(db, file);
+			sqlite3_close(file);
+			if (!saved) {
+				std::cerr << "\033[31mFailed to save database to '\033[0m" << persistPath << "\033[31m'.\033[0m" << std::endl;
+				return false;
+			}
+			lastPersist = std::chrono::steady_clock::now();
+			return true;
+		}
+
+
+		std::vector<Task> getAllTasks() const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<Task> allTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				allTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			for (Task& occurrence : expandOccurrences()) {
+				allTasks.push_back(std::move(occurrence));
+			}
+			return allTasks;
+		}
+
+		// Number of stored tasks. Use it as the row hint when sizing a TaskBatch.
+		size_t countTasks() const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT COUNT(*) FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			size_t count = 0;
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+			}
+
+			sqlite3_finalize(stmt);
+			return count;
+		}
+
+		// Titles of the stored tasks, without unstored recurring occurrences.
+		std::vector<std::string> getStoredTitles() const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT title FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::string> titles;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				titles.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+			}
+
+			sqlite3_finalize(stmt);
+			return titles;
+		}
+
+		// Number of stored tasks that match 'filter', the row hint for the filtered reads.
+		size_t countTasks(const TaskFilter& filter) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, ("SELECT COUNT(*) FROM tasks" + whereClause(filter) + ";").c_str(), -1, &stmt, nullptr);
+			bindFilter(stmt, filter, 1);
+
+			size_t count = 0;
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+			}
+
+			sqlite3_finalize(stmt);
+			return count;
+		}
+
+		void getAllTasks(TaskBatch& batch) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				batch.append(stmt);
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : expandOccurrences()) {
+				batch.append(TaskRecord::of(occurrence));
+			}
+		}
+
+
+		std::vector<std::string> getAvailableCategories() const {
+			if (cachedCategories) {
+				return *cachedCategories;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::string> availableCategories;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::transform(category.begin(), category.end(), category.begin(), ::tolower);
+				if (std::find(availableCategories.begin(), availableCategories.end(), category) == availableCategories.end()) {
+					availableCategories.push_back(category);
+				}
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : expandOccurrences()) {
+				std::string category = occurrence.getCategory();
+				std::transform(category.begin(), category.end(), category.begin(), ::tolower);
+				if (std::find(availableCategories.begin(), availableCategories.end(), category) == availableCategories.end()) {
+					availableCategories.push_back(category);
+				}
+			}
+			cachedCategories = availableCategories;
+			return availableCategories;
+		}
+
+		std::vector<std::string> getAvailablePriorities() const {
+			if (cachedPriorities) {
+				return *cachedPriorities;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::string> availablePriorities;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string priority = PrioToStr(static_cast<Priority>(sqlite3_column_int(stmt, 3)));
+				std::transform(priority.begin(), priority.end(), priority.begin(), ::tolower);
+				if (std::find(availablePriorities.begin(), availablePriorities.end(), priority) == availablePriorities.end()) {
+					availablePriorities.push_back(priority);
+				}
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : expandOccurrences()) {
+				std::string priority = PrioToStr(occurrence.getPriority());
+				std::transform(priority.begin(), priority.end(), priority.begin(), ::tolower);
+				if (std::find(availablePriorities.begin(), availablePriorities.end(), priority) == availablePriorities.end()) {
+					availablePriorities.push_back(priority);
+				}
+			}
+			cachedPriorities = availablePriorities;
+			return availablePriorities;
+		}
+
+		std::vector<std::string> getAvailableStatuses() const {
+			if (cachedStatuses) {
+				return *cachedStatuses;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks;
+				)", -1, &stmt, nullptr);
+
+			std::vector<std::string> availableStatuses;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string status = StatToStr(static_cast<Status>(sqlite3_column_int(stmt, 4)));
+				std::transform(status.begin(), status.end(), status.begin(), ::tolower);
+				if (std::find(availableStatuses.begin(), availableStatuses.end(), status) == availableStatuses.end()) {
+					availableStatuses.push_back(status);
+				}
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : expandOccurrences()) {
+				std::string status = StatToStr(occurrence.getStatus());
+				std::transform(status.begin(), status.end(), status.begin(), ::tolower);
+				if (std::find(availableStatuses.begin(), availableStatuses.end(), status) == availableStatuses.end()) {
+					availableStatuses.push_back(status);
+				}
+			}
+			cachedStatuses = availableStatuses;
+			return availableStatuses;
+		}
+
+
+		bool addTask(const Task& task) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT INTO tasks (title, category, dueDate, priority, status) VALUES (?, ?, ?, ?, ?);
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, task.getTitle().c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, task.getCategory().c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 3, task.getDueDate().c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 4, static_cast<int>(task.getPriority()));
+			sqlite3_bind_int(stmt, 5, static_cast<int>(task.getStatus()));
+
+			int result = sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+			if (result == SQLITE_DONE) {
+				tasksWritten(task.getTitle());
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (result == SQLITE_CONSTRAINT) {
+				std::cout << "\n\033[31mTask '" << task.getTitle() << "' already exists.\033[0m" << std::endl;
+				return false;
+			}
+			if (result == SQLITE_DONE && agendaLoaded && task.getStatus() != Status::Done) {
+				agenda.upsert(task.getTitle(), agendaScore(task.getDueDate(), task.getPriority()));
+			}
+			if (result == SQLITE_DONE && taskIndexLoaded) {
+				uint32_t id = taskIndex.intern(task.getTitle());
+				dependencies.addNode(id, dateToDays(task.getDueDate()), task.getStatus() == Status::Done);
+				allTaskIds.add(id);
+			}
+			return result == SQLITE_DONE;
+		}
+
+		// Inserts all tasks in one transaction. Tasks whose title already exists are skipped.
+		// Returns the number of inserted tasks.
+		size_t addTasks(const std::vector<Task>& tasks) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return 0;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT OR IGNORE INTO tasks (title, category, dueDate, priority, status) VALUES (?, ?, ?, ?, ?);
+				)", -1, &stmt, nullptr);
+
+			size_t added = 0;
+			for (const Task& task : tasks) {
+				sqlite3_bind_text(stmt, 1, task.getTitle().c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_text(stmt, 2, task.getCategory().c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_text(stmt, 3, task.getDueDate().c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_int(stmt, 4, static_cast<int>(task.getPriority()));
+				sqlite3_bind_int(stmt, 5, static_cast<int>(task.getStatus()));
+				if (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0) {
+					added++;
+				}
+				sqlite3_reset(stmt);
+			}
+
+			sqlite3_finalize(stmt);
+			tasksWritten(std::nullopt);
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return 0;
+			}
+			persistIfDue();
+			agendaLoaded = false;
+			taskIndexLoaded = false;
+			return added;
+		}
+
+		bool removeTask(const std::string& title) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				DELETE FROM tasks WHERE title = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			sqlite3_finalize(stmt);
+			if (changed) {
+				agenda.erase(title);
+			}
+			if (changed && taskIndexLoaded) {
+				if (std::optional<uint32_t> id = taskIndex.find(title)) {
+					dependencies.removeNode(*id);
+					allTaskIds.remove(*id);
+					for (auto& posting : tagPostings) {
+						posting.second.remove(*id);
+					}
+					taskIndex.forget(title);
+				}
+			}
+
+			// Occurrences of a recurring task stay removed, stored or not.
+			bool skipped = false;
+			if (std::optional<std::pair<RecurrenceRule, long long>> occurrence = parseOccurrence(title)) {
+				sqlite3_prepare_v2(db, R"(
+					INSERT OR IGNORE INTO recurrence_skips (occurrence, rule) VALUES (?, ?);
+					)", -1, &stmt, nullptr);
+
+				sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+				sqlite3_bind_text(stmt, 2, occurrence->first.title.c_str(), -1, SQLITE_STATIC);
+
+				skipped = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0;
+				sqlite3_finalize(stmt);
+			}
+			if (changed || skipped) {
+				tasksWritten(title);
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+			return changed || skipped;
+		}
+
+
+		std::optional<Task> findTask(const std::string& title) const {
+			auto cached = lookupCache.find(title);
+			if (cached != lookupCache.end()) {
+				return cached->second;
+			}
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE title = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+
+			std::optional<Task> foundTask = std::nullopt;
+			if (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				foundTask = Task(title, category, dueDate, priority, status);
+			};
+
+			sqlite3_finalize(stmt);
+
+			if (foundTask == std::nullopt && !isSkipped(title)) {
+				if (std::optional<std::pair<RecurrenceRule, long long>> occurrence = parseOccurrence(title)) {
+					const RecurrenceRule& rule = occurrence->first;
+					foundTask = Task(title, rule.category, daysToDate(occurrence->second), rule.priority, Status::Open);
+				}
+			}
+
+			if (lookupCache.size() >= LOOKUP_CACHE_LIMIT) {
+				lookupCache.clear();
+			}
+			lookupCache.emplace(title, foundTask);
+			return foundTask;
+		}
+
+
+		bool updatePriority(const std::string& title, const Priority& priority) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				UPDATE tasks SET priority = ? WHERE title = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(priority));
+			sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			if (!changed && result == SQLITE_DONE && materialize(title)) {
+				sqlite3_reset(stmt);
+				result = sqlite3_step(stmt);
+				changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			}
+			sqlite3_finalize(stmt);
+			if (changed) {
+				tasksWritten(title);
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (changed && agenda.contains(title)) {
+				std::optional<Task> task = findTask(title);
+				agenda.upsert(title, agendaScore(task->getDueDate(), priority));
+			}
+			return changed;
+		}
+
+		bool updateStatus(const std::string& title, const Status& status) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				UPDATE tasks SET status = ? WHERE title = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(status));
+			sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			if (!changed && result == SQLITE_DONE && materialize(title)) {
+				sqlite3_reset(stmt);
+				result = sqlite3_step(stmt);
+				changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			}
+			sqlite3_finalize(stmt);
+			if (changed) {
+				tasksWritten(title);
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (changed && agendaLoaded) {
+				if (status == Status::Done) {
+					agenda.erase(title);
+				}
+				else if (!agenda.contains(title)) {
+					std::optional<Task> task = findTask(title);
+					agenda.upsert(title, agendaScore(task->getDueDate(), task->getPriority()));
+				}
+			}
+			if (changed && taskIndexLoaded) {
+				if (std::optional<uint32_t> id = taskIndex.find(title)) {
+					dependencies.setDone(*id, status == Status::Done);
+				}
+			}
+			return changed;
+		}
+
+
+		// Set-based versions of updateStatus/updatePriority/removeTask. Each runs as a
+		// single statement in one transaction and returns the number of affected tasks;
+		// tasks that already have the new status or priority are not written or counted.
+		// Matching occurrences of recurring tasks in the recurrence window count too: they
+		// are stored before an update and skipped by a removal, like the single-task versions.
+		// They do not know which tasks changed, so the agenda, the dependency graph and
+		// the tag bitmaps are reloaded on next use.
+		size_t setStatusWhere(const TaskFilter& filter, Status status) {
+			return runBulk("UPDATE tasks SET status = ?1" + whereClause(filter, "status != ?1") + ";", filter, static_cast<int>(status),
+				OccurrenceAction::Store, [status](const Task& task) { return task.getStatus() != status; });
+		}
+
+		size_t setPriorityWhere(const TaskFilter& filter, Priority priority) {
+			return runBulk("UPDATE tasks SET priority = ?1" + whereClause(filter, "priority != ?1") + ";", filter, static_cast<int>(priority),
+				OccurrenceAction::Store, [priority](const Task& task) { return task.getPriority() != priority; });
+		}
+
+		size_t removeWhere(const TaskFilter& filter) {
+			return runBulk("DELETE FROM tasks" + whereClause(filter) + ";", filter, std::nullopt, OccurrenceAction::Skip,
+				[](const Task&) { return true; });
+		}
+
+
+		// The k open/in-progress tasks to work on next, best first.
+		std::vector<Task> nextTasks(size_t k) {
+			if (!agendaLoaded) {
+				loadAgenda();
+			}
+			std::vector<Task> next;
+			for (const std::string& title : agenda.top(k)) {
+				std::optional<Task> task = findTask(title);
+				if (task != std::nullopt) {
+					next.push_back(*task);
+				}
+			}
+			return next;
+		}
+
+		void setAgendaScore(const AgendaScore& score) {
+			agendaScore = score;
+			agendaLoaded = false;
+		}
+
+
+		// Adds a recurring task. Its occurrences show up in listings, filters and sorts
+		// while they fall into the recurrence window. The next tasks, dependencies and tags
+		// only see occurrences once they are stored, i.e. after their first edit.
+		bool addRecurrence(const RecurrenceRule& rule) {
+			if (!isValidDate(rule.startDate) || (rule.endDate && !isValidDate(*rule.endDate))) {
+				std::cout << "\n\033[31mInvalid date for Recurring Task '" << rule.title << "'.\033[0m" << std::endl;
+				return false;
+			}
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT INTO recurrences (title, category, priority, kind, every, startDate, endDate) VALUES (?, ?, ?, ?, ?, ?, ?);
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, rule.title.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, rule.category.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int(stmt, 3, static_cast<int>(rule.priority));
+			sqlite3_bind_int(stmt, 4, static_cast<int>(rule.repeat));
+			sqlite3_bind_int(stmt, 5, rule.every);
+			sqlite3_bind_text(stmt, 6, rule.startDate.c_str(), -1, SQLITE_STATIC);
+			if (rule.endDate) {
+				sqlite3_bind_text(stmt, 7, rule.endDate->c_str(), -1, SQLITE_STATIC);
+			}
+			else {
+				sqlite3_bind_null(stmt, 7);
+			}
+
+			int result = sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+			if (result == SQLITE_DONE) {
+				rulesWritten();
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (result == SQLITE_CONSTRAINT) {
+				std::cout << "\n\033[31mRecurring Task '" << rule.title << "' already exists.\033[0m" << std::endl;
+				return false;
+			}
+			return result == SQLITE_DONE;
+		}
+
+		// Removes a recurring task. Occurrences that were already stored stay as tasks.
+		bool removeRecurrence(const std::string& title) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				DELETE FROM recurrences WHERE title = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			sqlite3_finalize(stmt);
+			if (changed) {
+				rulesWritten();
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+			return changed;
+		}
+
+		std::vector<RecurrenceRule> getRecurrences() const {
+			return loadedRules();
+		}
+
+		// Due dates (DD-MM-YYYY, inclusive) for which occurrences are listed. Defaults to
+		// the last week and the next four weeks, counted from today.
+		void setRecurrenceWindow(const std::string& from, const std::string& to) {
+			if (!isValidDate(from) || !isValidDate(to)) {
+				throw std::invalid_argument("\033[31mDates have to be DD-MM-YYYY.\033[0m");
+			}
+			recurrenceWindow = std::make_pair(dateToDays(from), dateToDays(to));
+			cachedCategories.reset();
+			cachedPriorities.reset();
+			cachedStatuses.reset();
+			generation++;
+		}
+
+
+		// Records that 'blocker' has to be done before 'blocked'. Fails if either task does
+		// not exist or if the edge would make the tasks wait on each other.
+		bool addDependency(const std::string& blocker, const std::string& blocked) {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::optional<uint32_t> blockerId = taskIndex.find(blocker);
+			std::optional<uint32_t> blockedId = taskIndex.find(blocked);
+			if (!blockerId || !blockedId) {
+				std::cout << "\n\033[31mNo Task with name '\033[0m" << (blockerId ? blocked : blocker) << "\033[31m' found.\033[0m" << std::endl;
+				return false;
+			}
+			if (dependencies.hasEdge(*blockerId, *blockedId)) {
+				return true;
+			}
+			if (!dependencies.addEdge(*blockerId, *blockedId)) {
+				std::cout << "\n\033[31m'\033[0m" << blocker << "\033[31m' already waits on '\033[0m" << blocked << "\033[31m'.\033[0m" << std::endl;
+				return false;
+			}
+
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT OR IGNORE INTO dependencies (blocker, blocked) VALUES (?, ?);
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, blocker.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, blocked.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+			if (result == SQLITE_DONE) {
+				bumpVersion("dependencies");
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (result != SQLITE_DONE) {
+				dependencies.removeEdge(*blockerId, *blockedId);
+				return false;
+			}
+			return true;
+		}
+
+		bool removeDependency(const std::string& blocker, const std::string& blocked) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				DELETE FROM dependencies WHERE blocker = ? AND blocked = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, blocker.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, blocked.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			sqlite3_finalize(stmt);
+			if (changed) {
+				bumpVersion("dependencies");
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			std::optional<uint32_t> blockerId = taskIndex.find(blocker);
+			std::optional<uint32_t> blockedId = taskIndex.find(blocked);
+			if (changed && taskIndexLoaded && blockerId && blockedId) {
+				dependencies.removeEdge(*blockerId, *blockedId);
+			}
+			return changed;
+		}
+
+		// True while at least one task blocking 'title' is not done.
+		bool isBlocked(const std::string& title) {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::optional<uint32_t> id = taskIndex.find(title);
+			return id && dependencies.isBlocked(*id);
+		}
+
+		// All unfinished tasks, every one listed after the tasks blocking it.
+		std::vector<Task> getWorkOrder() {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			return tasksForIds(dependencies.workOrder());
+		}
+
+		// Unfinished tasks that can be started now, in work order.
+		std::vector<Task> getUnblockedTasks() {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::vector<uint32_t> ids;
+			for (uint32_t id : dependencies.workOrder()) {
+				if (!dependencies.isBlocked(id)) {
+					ids.push_back(id);
+				}
+			}
+			return tasksForIds(ids);
+		}
+
+		// Labels 'title' with 'tag'. Tags are stored lowercase.
+		bool addTag(const std::string& title, const std::string& tag) {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::optional<uint32_t> id = taskIndex.find(title);
+			if (!id) {
+				std::cout << "\n\033[31mNo Task with name '\033[0m" << title << "\033[31m' found.\033[0m" << std::endl;
+				return false;
+			}
+			if (!TagQuery::isValidTag(tag)) {
+				std::cout << "\n\033[31mTags cannot contain spaces or parentheses, or be AND/OR/NOT.\033[0m" << std::endl;
+				return false;
+			}
+			std::string name = tag;
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				INSERT OR IGNORE INTO tags (name) VALUES (?);
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+			sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+
+			sqlite3_prepare_v2(db, R"(
+				INSERT OR IGNORE INTO task_tags (title, tag) SELECT ?, id FROM tags WHERE name = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			sqlite3_finalize(stmt);
+			if (result == SQLITE_DONE) {
+				bumpVersion("tags");
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			if (result != SQLITE_DONE) {
+				return false;
+			}
+			tagPostings[name].add(*id);
+			return true;
+		}
+
+		bool removeTag(const std::string& title, const std::string& tag) {
+			WriteTransaction transaction(db);
+			if (!transaction.ok()) {
+				writeFailed(transaction);
+				return false;
+			}
+			std::string name = tag;
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				DELETE FROM task_tags WHERE title = ? AND tag = (SELECT id FROM tags WHERE name = ?);
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_STATIC);
+
+			int result = sqlite3_step(stmt);
+			bool changed = result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			sqlite3_finalize(stmt);
+			if (changed) {
+				bumpVersion("tags");
+			}
+			if (!transaction.commit()) {
+				writeFailed(transaction);
+				return false;
+			}
+			persistIfDue();
+
+			std::optional<uint32_t> id = taskIndex.find(title);
+			auto posting = tagPostings.find(name);
+			if (changed && taskIndexLoaded && id && posting != tagPostings.end()) {
+				posting->second.remove(*id);
+			}
+			return changed;
+		}
+
+		std::vector<std::string> getTags(const std::string& title) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT tags.name FROM task_tags JOIN tags ON tags.id = task_tags.tag WHERE task_tags.title = ? ORDER BY tags.name;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+
+			std::vector<std::string> tags;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				tags.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+			}
+
+			sqlite3_finalize(stmt);
+			return tags;
+		}
+
+		std::vector<std::string> getAvailableTags() {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::vector<std::string> availableTags;
+			for (const auto& posting : tagPostings) {
+				if (posting.second.cardinality() > 0) {
+					availableTags.push_back(posting.first);
+				}
+			}
+			std::sort(availableTags.begin(), availableTags.end());
+			return availableTags;
+		}
+
+		// Tasks matching a tag expression such as "urgent AND backend AND NOT waiting".
+		// Throws std::invalid_argument for malformed expressions.
+		std::vector<Task> filterByTags(const std::string& expression) {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			return tasksForIds(TagQuery(expression, tagPostings, allTaskIds).evaluate().toVector());
+		}
+
+		// Longest chain of unfinished tasks that wait on each other, first task first.
+		std::vector<Task> getCriticalPath() {
+			if (!taskIndexLoaded) {
+				loadTaskIndex();
+			}
+			std::vector<Task> path;
+			for (uint32_t id : dependencies.criticalPath()) {
+				std::optional<Task> task = findTask(taskIndex.title(id));
+				if (task != std::nullopt) {
+					path.push_back(*task);
+				}
+			}
+			return path;
+		}
+
+
+		std::vector<Task> filterByCategory(const std::string& cat) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE category = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, cat.c_str(), -1, SQLITE_STATIC);
+
+			std::vector<Task> filteredCategoryTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				filteredCategoryTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			for (Task& occurrence : occurrencesWhere([&cat](const Task& task) { return task.getCategory() == cat; })) {
+				filteredCategoryTasks.push_back(std::move(occurrence));
+			}
+			return filteredCategoryTasks;
+		}
+
+		std::vector<Task> filterByPriority(Priority prio) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE priority = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(prio));
+
+			std::vector<Task> filteredPriorityTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				filteredPriorityTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			for (Task& occurrence : occurrencesWhere([&prio](const Task& task) { return task.getPriority() == prio; })) {
+				filteredPriorityTasks.push_back(std::move(occurrence));
+			}
+			return filteredPriorityTasks;
+		}
+
+		std::vector<Task> filterByStatus(Status stat) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE status = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(stat));
+
+			std::vector<Task> filteredStatusTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				filteredStatusTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			for (Task& occurrence : occurrencesWhere([&stat](const Task& task) { return task.getStatus() == stat; })) {
+				filteredStatusTasks.push_back(std::move(occurrence));
+			}
+			return filteredStatusTasks;
+		}
+
+		void filterByCategory(const std::string& cat, TaskBatch& batch) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE category = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_text(stmt, 1, cat.c_str(), -1, SQLITE_STATIC);
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				batch.append(stmt);
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : occurrencesWhere([&cat](const Task& task) { return task.getCategory() == cat; })) {
+				batch.append(TaskRecord::of(occurrence));
+			}
+		}
+
+		void filterByPriority(Priority prio, TaskBatch& batch) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE priority = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(prio));
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				batch.append(stmt);
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : occurrencesWhere([&prio](const Task& task) { return task.getPriority() == prio; })) {
+				batch.append(TaskRecord::of(occurrence));
+			}
+		}
+
+		void filterByStatus(Status stat, TaskBatch& batch) const {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks WHERE status = ?;
+				)", -1, &stmt, nullptr);
+
+			sqlite3_bind_int(stmt, 1, static_cast<int>(stat));
+
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				batch.append(stmt);
+			}
+
+			sqlite3_finalize(stmt);
+			for (const Task& occurrence : occurrencesWhere([&stat](const Task& task) { return task.getStatus() == stat; })) {
+				batch.append(TaskRecord::of(occurrence));
+			}
+		}
+
+
+		std::vector<Task> sortByTitle() {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks ORDER BY title ASC;
+				)", -1, &stmt, nullptr);
+
+			std::vector<Task> orderedTitleTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				orderedTitleTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			mergeOccurrences(orderedTitleTasks, titleBefore);
+			return orderedTitleTasks;
+		}
+
+		std::vector<Task> sortByCategory() {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks ORDER BY category ASC;
+				)", -1, &stmt, nullptr);
+
+			std::vector<Task> orderedCategoryTasks;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				orderedCategoryTasks.push_back(Task(title, category, dueDate, priority, status));
+			}
+
+			sqlite3_finalize(stmt);
+			mergeOccurrences(orderedCategoryTasks, categoryBefore);
+			return orderedCategoryTasks;
+		}
+
+		std::vector<Task> sortByPriority() {
+			sqlite3_stmt* stmt;
+			sqlite3_prepare_v2(db, R"(
+				SELECT * FROM tasks ORDER BY priority DESC;
 				)", -1, &stmt, nullptr);
 
-			std::vector<Task> allTasks;
+			std::vector<Task> orderedPriorityTasks;
 			while (sqlite3_step(stmt) == SQLITE_ROW) {
 				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
 				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
 				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
 				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
 				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				allTasks.push_back(Task(title, category, dueDate, priority, status));
+				orderedPriorityTasks.push_back(Task(title, category, dueDate, priority, status));
 			}
 
 			sqlite3_finalize(stmt);
-			return allTasks;
+			mergeOccurrences(orderedPriorityTasks, priorityBefore);
+			return orderedPriorityTasks;
 		}
 
-
-		std::vector<std::string> getAvailableCategories() const {
+		std::vector<Task> sortByStatus() {
 			sqlite3_stmt* stmt;
 			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks;
+				SELECT * FROM tasks ORDER BY status;
 				)", -1, &stmt, nullptr);
 
-			std::vector<std::string> availableCategories;
+			std::vector<Task> orderedStatusTasks;
 			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
 				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::transform(category.begin(), category.end(), category.begin(), ::tolower);
-				if (std::find(availableCategories.begin(), availableCategories.end(), category) == availableCategories.end()) {
-					availableCategories.push_back(category);
-				}
+				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
+				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
+				orderedStatusTasks.push_back(Task(title, category, dueDate, priority, status));
 			}
 
 			sqlite3_finalize(stmt);
-			return availableCategories;
+			mergeOccurrences(orderedStatusTasks, statusBefore);
+			return orderedStatusTasks;
 		}
 
-		std::vector<std::string> getAvailablePriorities() const {
+		void sortByTitle(TaskBatch& batch) const {
 			sqlite3_stmt* stmt;
 			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks;
+				SELECT * FROM tasks ORDER BY title ASC;
 				)", -1, &stmt, nullptr);
 
-			std::vector<std::string> availablePriorities;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string priority = reinterpret_cast<const char*>(sqlite3_column_int(stmt, 3));
-				std::transform(priority.begin(), priority.end(), priority.begin(), ::tolower);
-				if (std::find(availablePriorities.begin(), availablePriorities.end(), priority) == availablePriorities.end()) {
-					availablePriorities.push_back(priority);
-				}
-			}
+			appendSorted(stmt, titleBefore, batch);
 
 			sqlite3_finalize(stmt);
-			return availablePriorities;
 		}
 
-		std::vector<std::string> getAvailableStatuses() const {
+		void sortByCategory(TaskBatch& batch) const {
 			sqlite3_stmt* stmt;
 			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks;
+				SELECT * FROM tasks ORDER BY category ASC;
 				)", -1, &stmt, nullptr);
 
-			std::vector<std::string> availableStatuses;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string status = reinterpret_cast<const char*>(sqlite3_column_int(stmt, 4));
-				std::transform(status.begin(), status.end(), status.begin(), ::tolower);
-				if (std::find(availableStatuses.begin(), availableStatuses.end(), status) == availableStatuses.end()) {
-					availableStatuses.push_back(status);
-				}
-			}
+			appendSorted(stmt, categoryBefore, batch);
 
 			sqlite3_finalize(stmt);
-			return availableStatuses;
 		}
 
-
-		bool addTask(const Task& task) {
+		void sortByPriority(TaskBatch& batch) const {
 			sqlite3_stmt* stmt;
 			sqlite3_prepare_v2(db, R"(
-				INSERT INTO tasks (title, category, dueDate, priority, status) VALUES (?, ?, ?, ?, ?);
+				SELECT * FROM tasks ORDER BY priority DESC;
 				)", -1, &stmt, nullptr);
 
-			sqlite3_bind_text(stmt, 1, task.getTitle().c_str(), -1, SQLITE_STATIC);
-			sqlite3_bind_text(stmt, 2, task.getCategory().c_str(), -1, SQLITE_STATIC);
-			sqlite3_bind_text(stmt, 3, task.getDueDate().c_str(), -1, SQLITE_STATIC);
-			sqlite3_bind_int(stmt, 4, static_cast<int>(task.getPriority()));
-			sqlite3_bind_int(stmt, 5, static_cast<int>(task.getStatus()));
+			appendSorted(stmt, priorityBefore, batch);
 
-			int result = sqlite3_step(stmt);
 			sqlite3_finalize(stmt);
-
-			if (result == SQLITE_CONSTRAINT) {
-				std::cout << "\n\033[31mTask '" << task.getTitle() << "' already exists.\033[0m" << std::endl;
-				return false;
-			}
-			return result == SQLITE_DONE;
 		}
 
-		bool removeTask(const std::string& title) {
+		void sortByStatus(TaskBatch& batch) const {
 			sqlite3_stmt* stmt;
 			sqlite3_prepare_v2(db, R"(
-				DELETE FROM tasks WHERE title = ?;
+				SELECT * FROM tasks ORDER BY status;
 				)", -1, &stmt, nullptr);
 
-			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+			appendSorted(stmt, statusBefore, batch);
 
-			int result = sqlite3_step(stmt);
 			sqlite3_finalize(stmt);
+		}
+};
 
-			return result == SQLITE_DONE && sqlite3_changes(db) > 0;
+
+// Fixed-size worker pool used to fan work out over shards.
+class ThreadPool {
+	private:
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex lock;
+		std::condition_variable wake;
+		bool stopping = false;
+
+		void work() {
+			while (true) {
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+					if (stopping && jobs.empty()) {
+						return;
+					}
+					job = std::move(jobs.front());
+					jobs.pop();
+				}
+				job();
+			}
 		}
 
+	public:
+		explicit ThreadPool(size_t threadCount) {
+			for (size_t i = 0; i < std::max<size_t>(threadCount, 1); i++) {
+				workers.emplace_back([this] { work(); });
+			}
+		}
 
-		std::optional<Task> findTask(const std::string& title) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks WHERE title = ?;
-				)", -1, &stmt, nullptr);
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+		}
 
-			sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
 
-			std::optional<Task> foundTask = std::nullopt;
-			if (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				foundTask = Task(title, category, dueDate, priority, status);
-			};
+		template <typename Fn>
+		std::future<std::invoke_result_t<Fn>> submit(Fn fn) {
+			auto job = std::make_shared<std::packaged_task<std::invoke_result_t<Fn>()>>(std::move(fn));
+			std::future<std::invoke_result_t<Fn>> result = job->get_future();
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				jobs.push([job] { (*job)(); });
+			}
+			wake.notify_one();
+			return result;
+		}
+};
 
-			sqlite3_finalize(stmt);
 
-			return foundTask;
+// Spreads tasks over several database files, one TaskManager per file. A task
+// lives in the shard picked by hashing its (lowercase) category, so writes to
+// different categories hit different files and can run in parallel. Queries
+// over all tasks are run on every shard at once and merged afterwards.
+// Library only: it covers the task queries and writes, but not dependencies, tags,
+// recurring tasks or the next tasks, so the menu and the commands keep using
+// TaskManager. bench measures it.
+class ShardedTaskManager {
+	private:
+		struct Shard {
+			TaskManager manager;
+			std::mutex lock;
+
+			Shard(const std::string& path, StorageProfile profile) : manager(path, profile) {}
+		};
+
+		std::vector<std::unique_ptr<Shard>> shards;
+		mutable ThreadPool pool;
+
+		// FNV-1a, so the category -> shard mapping does not change between builds.
+		static uint64_t hashCategory(const std::string& category) {
+			uint64_t hash = 14695981039346656037ull;
+			for (char c : category) {
+				hash ^= static_cast<unsigned char>(::tolower(static_cast<unsigned char>(c)));
+				hash *= 1099511628211ull;
+			}
+			return hash;
 		}
 
+		Shard& shardFor(const std::string& category) const {
+			return *shards[hashCategory(category) % shards.size()];
+		}
 
-		bool updatePriority(const std::string& title, const Priority& priority) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				UPDATE tasks SET priority = ? WHERE title = ?;
-				)", -1, &stmt, nullptr);
+		// Runs fn on every shard in parallel and returns the results in shard order.
+		template <typename Fn>
+		auto fanOut(Fn fn) const -> std::vector<std::invoke_result_t<Fn, TaskManager&>> {
+			using Result = std::invoke_result_t<Fn, TaskManager&>;
+			std::vector<std::future<Result>> pending;
+			for (const std::unique_ptr<Shard>& shard : shards) {
+				Shard* target = shard.get();
+				pending.push_back(pool.submit([target, fn] {
+					std::lock_guard<std::mutex> guard(target->lock);
+					return fn(target->manager);
+				}));
+			}
 
-			sqlite3_bind_int(stmt, 1, static_cast<int>(priority));
-			sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_STATIC);
+			std::vector<Result> results;
+			for (std::future<Result>& result : pending) {
+				results.push_back(result.get());
+			}
+			return results;
+		}
 
-			int result = sqlite3_step(stmt);
-			sqlite3_finalize(stmt);
+		// Title -> shard of every task. Titles are unique over all shards: an add claims its
+		// title here before inserting, so a concurrent add of the same title is rejected
+		// even while the first insert is still running. Lookups, updates and removals use
+		// it to go to the one shard holding the task. The shards are expected to be
+		// written by this process only.
+		std::mutex titlesLock;
+		std::unordered_map<std::string, size_t> titleShard;
+
+		void loadTitles() {
+			std::vector<std::vector<std::string>> titles = fanOut([](TaskManager& manager) {
+				return manager.getStoredTitles();
+			});
+
+			std::lock_guard<std::mutex> guard(titlesLock);
+			titleShard.clear();
+			for (size_t i = 0; i < titles.size(); i++) {
+				for (const std::string& title : titles[i]) {
+					titleShard.emplace(title, i);
+				}
+			}
+		}
 
-			return result == SQLITE_DONE && sqlite3_changes(db) > 0;
+		std::optional<size_t> shardOf(const std::string& title) {
+			std::lock_guard<std::mutex> guard(titlesLock);
+			auto found = titleShard.find(title);
+			return found == titleShard.end() ? std::nullopt : std::optional<size_t>(found->second);
 		}
 
-		bool updateStatus(const std::string& title, const Status& status) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				UPDATE tasks SET status = ? WHERE title = ?;
-				)", -1, &stmt, nullptr);
+		size_t shardIndex(const std::string& category) const {
+			return hashCategory(category) % shards.size();
+		}
 
-			sqlite3_bind_int(stmt, 1, static_cast<int>(status));
-			sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_STATIC);
+		// Runs fn on the shard holding 'title'. Returns 'missing' if no shard does.
+		template <typename Fn, typename Result>
+		Result onTaskShard(const std::string& title, Fn fn, Result missing) {
+			std::optional<size_t> index = shardOf(title);
+			if (!index) {
+				return missing;
+			}
+			Shard& shard = *shards[*index];
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return fn(shard.manager);
+		}
 
-			int result = sqlite3_step(stmt);
-			sqlite3_finalize(stmt);
+		// k-way merge of per-shard results that are each already sorted by 'less'.
+		template <typename Less>
+		static std::vector<Task> mergeSorted(std::vector<std::vector<Task>> runs, Less less) {
+			size_t total = 0;
+			for (const std::vector<Task>& run : runs) {
+				total += run.size();
+			}
+
+			// (run, position) pairs; the heap keeps the smallest head on top and
+			// breaks ties by run index so the merge is stable.
+			using Head = std::pair<size_t, size_t>;
+			auto greater = [&runs, &less](const Head& a, const Head& b) {
+				const Task& taskA = runs[a.first][a.second];
+				const Task& taskB = runs[b.first][b.second];
+				if (less(taskB, taskA)) { return true; }
+				if (less(taskA, taskB)) { return false; }
+				return a.first > b.first;
+			};
+			std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+			for (size_t i = 0; i < runs.size(); i++) {
+				if (!runs[i].empty()) {
+					heads.push({i, 0});
+				}
+			}
 
-			return result == SQLITE_DONE && sqlite3_changes(db) > 0;
+			std::vector<Task> merged;
+			merged.reserve(total);
+			while (!heads.empty()) {
+				Head head = heads.top();
+				heads.pop();
+				merged.push_back(std::move(runs[head.first][head.second]));
+				if (head.second + 1 < runs[head.first].size()) {
+					heads.push({head.first, head.second + 1});
+				}
+			}
+			return merged;
 		}
 
+		static std::vector<Task> concat(std::vector<std::vector<Task>> runs) {
+			std::vector<Task> all;
+			for (std::vector<Task>& run : runs) {
+				all.insert(all.end(), std::make_move_iterator(run.begin()), std::make_move_iterator(run.end()));
+			}
+			return all;
+		}
 
-		std::vector<Task> filterByCategory(const std::string& cat) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks WHERE category = ?;
-				)", -1, &stmt, nullptr);
+		static std::vector<std::string> unionOf(const std::vector<std::vector<std::string>>& lists) {
+			std::vector<std::string> values;
+			std::unordered_set<std::string> seen;
+			for (const std::vector<std::string>& list : lists) {
+				for (const std::string& value : list) {
+					if (seen.insert(value).second) {
+						values.push_back(value);
+					}
+				}
+			}
+			return values;
+		}
 
-			sqlite3_bind_text(stmt, 1, cat.c_str(), -1, SQLITE_STATIC);
+		// Runs the bulk operation on the shard of the filtered category, or on all shards
+		// in parallel. The counts are summed.
+		template <typename Fn>
+		size_t bulk(const TaskFilter& filter, Fn fn) {
+			if (filter.category) {
+				Shard& shard = shardFor(*filter.category);
+				std::lock_guard<std::mutex> guard(shard.lock);
+				return fn(shard.manager);
+			}
+			size_t changed = 0;
+			for (size_t shardChanged : fanOut(fn)) {
+				changed += shardChanged;
+			}
+			return changed;
+		}
 
-			std::vector<Task> filteredCategoryTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				filteredCategoryTasks.push_back(Task(title, category, dueDate, priority, status));
+	public:
+		// Shard i is stored in '<pathPrefix>.shard<i>.db'.
+		explicit ShardedTaskManager(size_t shardCount, const std::string& pathPrefix = "./data/tasks_sql",
+			StorageProfile profile = StorageProfile::Durable)
+			: pool(shardCount)
+		{
+			if (shardCount == 0) {
+				throw std::invalid_argument("ShardedTaskManager needs at least one shard.");
 			}
+			for (size_t i = 0; i < shardCount; i++) {
+				shards.push_back(std::make_unique<Shard>(pathPrefix + ".shard" + std::to_string(i) + ".db", profile));
+			}
+			loadTitles();
+		}
 
-			sqlite3_finalize(stmt);
-			return filteredCategoryTasks;
+		size_t shardCount() const { return shards.size(); }
+
+
+		std::vector<Task> getAllTasks() const {
+			return concat(fanOut([](TaskManager& manager) { return manager.getAllTasks(); }));
 		}
 
-		std::vector<Task> filterByPriority(Priority prio) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks WHERE priority = ?;
-				)", -1, &stmt, nullptr);
+		size_t countTasks() const {
+			size_t count = 0;
+			for (size_t shardTasks : fanOut([](TaskManager& manager) { return manager.countTasks(); })) {
+				count += shardTasks;
+			}
+			return count;
+		}
 
-			sqlite3_bind_int(stmt, 1, static_cast<int>(prio));
+		std::vector<std::string> getAvailableCategories() const {
+			return unionOf(fanOut([](TaskManager& manager) { return manager.getAvailableCategories(); }));
+		}
 
-			std::vector<Task> filteredPriorityTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				filteredPriorityTasks.push_back(Task(title, category, dueDate, priority, status));
+		std::vector<std::string> getAvailablePriorities() const {
+			return unionOf(fanOut([](TaskManager& manager) { return manager.getAvailablePriorities(); }));
+		}
+
+		std::vector<std::string> getAvailableStatuses() const {
+			return unionOf(fanOut([](TaskManager& manager) { return manager.getAvailableStatuses(); }));
+		}
+
+
+		bool addTask(const Task& task) {
+			const size_t index = shardIndex(task.getCategory());
+			{
+				std::lock_guard<std::mutex> guard(titlesLock);
+				if (!titleShard.emplace(task.getTitle(), index).second) {
+					std::cout << "\n\033[31mTask '" << task.getTitle() << "' already exists.\033[0m" << std::endl;
+					return false;
+				}
 			}
 
-			sqlite3_finalize(stmt);
-			return filteredPriorityTasks;
+			Shard& shard = *shards[index];
+			bool added;
+			{
+				std::lock_guard<std::mutex> guard(shard.lock);
+				added = shard.manager.addTask(task);
+			}
+			if (!added) {
+				std::lock_guard<std::mutex> guard(titlesLock);
+				titleShard.erase(task.getTitle());
+			}
+			return added;
 		}
 
-		std::vector<Task> filterByStatus(Status stat) const {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks WHERE status = ?;
-				)", -1, &stmt, nullptr);
+		// Groups the tasks by shard and inserts every group in parallel, one
+		// transaction per shard. Like TaskManager::addTasks, a title that already
+		// exists (or repeats within 'tasks') is skipped. Returns the number of inserted tasks.
+		size_t addTasks(const std::vector<Task>& tasks) {
+			std::vector<std::vector<Task>> groups(shards.size());
+			{
+				std::lock_guard<std::mutex> guard(titlesLock);
+				for (const Task& task : tasks) {
+					const size_t index = shardIndex(task.getCategory());
+					if (titleShard.emplace(task.getTitle(), index).second) {
+						groups[index].push_back(task);
+					}
+				}
+			}
 
-			sqlite3_bind_int(stmt, 1, static_cast<int>(stat));
+			std::vector<std::future<size_t>> pending;
+			for (size_t i = 0; i < shards.size(); i++) {
+				if (groups[i].empty()) {
+					continue;
+				}
+				Shard* shard = shards[i].get();
+				const std::vector<Task>* group = &groups[i];
+				pending.push_back(pool.submit([shard, group] {
+					std::lock_guard<std::mutex> guard(shard->lock);
+					return shard->manager.addTasks(*group);
+				}));
+			}
 
-			std::vector<Task> filteredStatusTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				filteredStatusTasks.push_back(Task(title, category, dueDate, priority, status));
+			size_t added = 0, claimed = 0;
+			for (std::future<size_t>& result : pending) {
+				added += result.get();
+			}
+			for (const std::vector<Task>& group : groups) {
+				claimed += group.size();
+			}
+			if (added != claimed) {
+				loadTitles();
+			}
+			return added;
+		}
+
+		bool removeTask(const std::string& title) {
+			bool removed = onTaskShard(title, [&title](TaskManager& manager) { return manager.removeTask(title); }, false);
+			if (removed) {
+				std::lock_guard<std::mutex> guard(titlesLock);
+				titleShard.erase(title);
 			}
+			return removed;
+		}
 
-			sqlite3_finalize(stmt);
-			return filteredStatusTasks;
+
+		std::optional<Task> findTask(const std::string& title) {
+			return onTaskShard(title, [&title](TaskManager& manager) { return manager.findTask(title); }, std::optional<Task>());
 		}
 
 
-		std::vector<Task> sortByTitle() {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks ORDER BY title ASC;
-				)", -1, &stmt, nullptr);
+		bool updatePriority(const std::string& title, const Priority& priority) {
+			return onTaskShard(title, [&](TaskManager& manager) { return manager.updatePriority(title, priority); }, false);
+		}
 
-			std::vector<Task> orderedTitleTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				orderedTitleTasks.push_back(Task(title, category, dueDate, priority, status));
+		bool updateStatus(const std::string& title, const Status& status) {
+			return onTaskShard(title, [&](TaskManager& manager) { return manager.updateStatus(title, status); }, false);
+		}
+
+
+		size_t setStatusWhere(const TaskFilter& filter, Status status) {
+			return bulk(filter, [&](TaskManager& manager) { return manager.setStatusWhere(filter, status); });
+		}
+
+		size_t setPriorityWhere(const TaskFilter& filter, Priority priority) {
+			return bulk(filter, [&](TaskManager& manager) { return manager.setPriorityWhere(filter, priority); });
+		}
+
+		size_t removeWhere(const TaskFilter& filter) {
+			size_t removed = bulk(filter, [&](TaskManager& manager) { return manager.removeWhere(filter); });
+			if (removed > 0) {
+				loadTitles();
 			}
+			return removed;
+		}
+
+
+		// A category lives in exactly one shard, so no fan-out is needed.
+		std::vector<Task> filterByCategory(const std::string& cat) const {
+			Shard& shard = shardFor(cat);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return shard.manager.filterByCategory(cat);
+		}
 
-			sqlite3_finalize(stmt);
-			return orderedTitleTasks;
+		std::vector<Task> filterByPriority(Priority prio) const {
+			return concat(fanOut([prio](TaskManager& manager) { return manager.filterByPriority(prio); }));
 		}
 
-		std::vector<Task> sortByCategory() {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks ORDER BY category ASC;
-				)", -1, &stmt, nullptr);
+		std::vector<Task> filterByStatus(Status stat) const {
+			return concat(fanOut([stat](TaskManager& manager) { return manager.filterByStatus(stat); }));
+		}
 
-			std::vector<Task> orderedCategoryTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				orderedCategoryTasks.push_back(Task(title, category, dueDate, priority, status));
-			}
 
-			sqlite3_finalize(stmt);
-			return orderedCategoryTasks;
+		// The merge comparators mirror the ORDER BY clauses of the TaskManager sorts.
+		std::vector<Task> sortByTitle() const {
+			return mergeSorted(fanOut([](TaskManager& manager) { return manager.sortByTitle(); }),
+				[](const Task& a, const Task& b) { return a.getTitle() < b.getTitle(); });
 		}
 
-		std::vector<Task> sortByPriority() {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks ORDER BY priority DESC;
-				)", -1, &stmt, nullptr);
+		std::vector<Task> sortByCategory() const {
+			return mergeSorted(fanOut([](TaskManager& manager) { return manager.sortByCategory(); }),
+				[](const Task& a, const Task& b) { return a.getCategory() < b.getCategory(); });
+		}
 
-			std::vector<Task> orderedPriorityTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				orderedPriorityTasks.push_back(Task(title, category, dueDate, priority, status));
-			}
+		std::vector<Task> sortByPriority() const {
+			return mergeSorted(fanOut([](TaskManager& manager) { return manager.sortByPriority(); }),
+				[](const Task& a, const Task& b) { return a.getPriority() > b.getPriority(); });
+		}
 
-			sqlite3_finalize(stmt);
-			return orderedPriorityTasks;
+		std::vector<Task> sortByStatus() const {
+			return mergeSorted(fanOut([](TaskManager& manager) { return manager.sortByStatus(); }),
+				[](const Task& a, const Task& b) { return a.getStatus() < b.getStatus(); });
 		}
 
-		std::vector<Task> sortByStatus() {
-			sqlite3_stmt* stmt;
-			sqlite3_prepare_v2(db, R"(
-				SELECT * FROM tasks ORDER BY status;
-				)", -1, &stmt, nullptr);
 
-			std::vector<Task> orderedStatusTasks;
-			while (sqlite3_step(stmt) == SQLITE_ROW) {
-				std::string title 	 = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-				std::string category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-				std::string dueDate  = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-				Priority priority 	 = static_cast<Priority>(sqlite3_column_int(stmt, 3));
-				Status status 		 = static_cast<Status>(sqlite3_column_int(stmt, 4));
-				orderedStatusTasks.push_back(Task(title, category, dueDate, priority, status));
+		// Every shard ranks its own agenda; the best k of all shards are merged by the same score.
+		std::vector<Task> nextTasks(size_t k) {
+			AgendaScore score;
+			std::vector<Task> next = mergeSorted(fanOut([k](TaskManager& manager) { return manager.nextTasks(k); }),
+				[&score](const Task& a, const Task& b) {
+					long long scoreA = score(a.getDueDate(), a.getPriority());
+					long long scoreB = score(b.getDueDate(), b.getPriority());
+					return scoreA != scoreB ? scoreA < scoreB : a.getTitle() < b.getTitle();
+				});
+			if (next.size() > k) {
+				next.erase(next.begin() + k, next.end());
 			}
-
-			sqlite3_finalize(stmt);
-			return orderedStatusTasks;
+			return next;
 		}
 };
 
@@ -458,29 +3658,98 @@ std::string StatToStr (const Status& stat) {
 	throw std::invalid_argument("\033[31mInvalid Status.\033[0m");
 }
 
+StorageProfile strToProfile(const std::string& inp) {
+	std::string lower = inp;
+	std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+	if (lower == "durable") {
+		return StorageProfile::Durable;
+	}
+	if (lower == "balanced") {
+		return StorageProfile::Balanced;
+	}
+	if (lower == "fast") {
+		return StorageProfile::Fast;
+	}
+	if (lower == "in-memory" || lower == "inmemory") {
+		return StorageProfile::InMemory;
+	}
+	throw std::invalid_argument("\033[31mInvalid Storage Profile:\033[0m " + inp);
+}
 
-constexpr const char* EXIT_STR = "0";
+std::string ProfileToStr(const StorageProfile& profile) {
+	switch (profile) {
+		case StorageProfile::Durable:  return "durable";
+		case StorageProfile::Balanced: return "balanced";
+		case StorageProfile::Fast: 	   return "fast";
+		case StorageProfile::InMemory: return "in-memory";
+	}
+	throw std::invalid_argument("\033[31mInvalid Storage Profile.\033[0m");
+}
 
-std::string valiDATE() {
-	const int MIN = 1;
-    const int MONTHS = 12;
-    const int LONG_MONTH_DAYS = 31;
-    const int SHORT_MONTH_DAYS = 30;
-    const int FEBRUARY_DAYS = 28;
-    const int LEAP_FEBRUARY_DAYS = 29;
+const std::vector<std::string> WEEKDAY_STRS = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
 
-    const std::vector<int> LONG_MONTHS = {1,3,5,7,8,10,12};
-    const std::vector<int> SHORT_MONTHS = {4,6,9,11};
-    const int FEBRUARY_MONTH = 2;
+// Parses 'days:N', 'weeks:N', 'weekday:mon' or 'monthday:D' into a repeat kind and its value.
+std::pair<Repeat, int> strToRepeat(const std::string& inp) {
+	std::string lower = inp;
+	std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+	size_t colon = lower.find(':');
+	std::string kind = lower.substr(0, colon);
+	std::string value = (colon == std::string::npos) ? "" : lower.substr(colon + 1);
+
+	if (kind == "weekday") {
+		for (size_t i = 0; i < WEEKDAY_STRS.size(); i++) {
+			std::string weekday = WEEKDAY_STRS[i];
+			std::transform(weekday.begin(), weekday.end(), weekday.begin(), ::tolower);
+			if (value == weekday) {
+				return {Repeat::Weekday, static_cast<int>(i)};
+			}
+		}
+	}
+	else if (kind == "days" || kind == "weeks" || kind == "monthday") {
+		int every = std::stoi(value);
+		if (every >= 1 && (kind != "monthday" || every <= 31)) {
+			return {kind == "days" ? Repeat::Days : kind == "weeks" ? Repeat::Weeks : Repeat::MonthDay, every};
+		}
+	}
+	throw std::invalid_argument("\033[31mInvalid Repeat:\033[0m " + inp);
+}
 
-    const int DATE_LENGTH = 10;
+std::string RepeatToStr(const RecurrenceRule& rule) {
+	switch (rule.repeat) {
+		case Repeat::Days: 	   return "every " + std::to_string(rule.every) + " day(s)";
+		case Repeat::Weeks:    return "every " + std::to_string(rule.every) + " week(s)";
+		case Repeat::Weekday:  return "every " + WEEKDAY_STRS.at(rule.every);
+		case Repeat::MonthDay: return "day " + std::to_string(rule.every) + " of every month";
+	}
+	throw std::invalid_argument("\033[31mInvalid Repeat.\033[0m");
+}
 
-    const std::vector<char> SEPARATORS = {'-', '/', '.', ','};
+void printRecurrences(const std::vector<RecurrenceRule>& rules) {
+	std::cout << "\n--------------------------------------------------------------------------" << std::endl;
+	std::cout << "Recurring Tasks:\n" << std::endl;
+	for (const RecurrenceRule& rule : rules) {
+		std::cout << "Title: " << rule.title << ", Category: " << rule.category << ", Priority: " << PrioToStr(rule.priority)
+				  << ", Repeats: " << RepeatToStr(rule) << " from " << rule.startDate
+				  << (rule.endDate ? " until " + *rule.endDate : "") << std::endl;
+	}
+	std::cout << "--------------------------------------------------------------------------\n" << std::endl;
+}
+
+
+constexpr const char* EXIT_STR = "0";
+
+// Today's date in the DD-MM-YYYY format used for due dates.
+std::string todayStr() {
+	std::time_t now = std::time(nullptr);
+	std::tm local = *std::localtime(&now);
+	char buffer[11];
+	std::strftime(buffer, sizeof(buffer), "%d-%m-%Y", &local);
+	return buffer;
+}
 
+std::string valiDATE() {
     std::string date;
-    bool date_valid = false;
-    int day, month, year;
-    int max_days = 0;
+    DateCheck check;
 
     do {
 		std::cout << "-> ";
@@ -491,56 +3760,14 @@ std::string valiDATE() {
 			break;
 		}
 
-        if (date.size() != DATE_LENGTH) {
+        check = checkDate(date);
+        if (check == DateCheck::BadFormat) {
             std::cout << "\033[31mInvalid date format.\033[0m" << std::endl;
-            continue;
         }
-        char sep1 = date[2];
-        char sep2 = date[5];
-
-        if ((std::find(SEPARATORS.begin(), SEPARATORS.end(), sep1) == SEPARATORS.end()) || 
-        (std::find(SEPARATORS.begin(), SEPARATORS.end(), sep2) == SEPARATORS.end())) {
-            std::cout << "\033[31mInvalid date format.\033[0m" << std::endl;
-            continue;
-        }
-        try {
-            day = std::stoi(date.substr(0,2));
-            month = std::stoi(date.substr(3,2));
-            year = std::stoi(date.substr(6,4));
-        }
-        catch (const std::exception&) {
-            std::cout << "\033[31mInvalid date format.\033[0m" << std::endl;
-            continue;
-        }
-        if (day >= MIN && day <= LONG_MONTH_DAYS && month >= MIN && month <= MONTHS && year >= MIN) {
-            // Check february
-            if (month == FEBRUARY_MONTH) {
-                if ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0)) {
-                    max_days = LEAP_FEBRUARY_DAYS;
-                }
-                else {
-                    max_days = FEBRUARY_DAYS;
-                }
-            }
-            // Check long months
-            else if (std::find(LONG_MONTHS.begin(), LONG_MONTHS.end(), month) != LONG_MONTHS.end()) {
-                max_days = LONG_MONTH_DAYS;
-            }
-            // Check short months
-            else if (std::find(SHORT_MONTHS.begin(), SHORT_MONTHS.end(), month) != SHORT_MONTHS.end()) {
-                max_days = SHORT_MONTH_DAYS;
-            }
-            if (day <= max_days) {
-                date_valid = true;
-            }
-            else {
-                std::cout << "\033[31mInvalid date.\033[0m" << std::endl;
-            }     
-        }
-        else {
+        else if (check == DateCheck::BadDay) {
             std::cout << "\033[31mInvalid date.\033[0m" << std::endl;
-        } 
-    } while (date_valid == false);
+        }
+    } while (check != DateCheck::Valid);
 	return date;
 }
 
@@ -595,7 +3822,31 @@ std::string checkInputPrompt(const std::vector<std::string>& allowedValues) {
 }
 
 
-void printMany(const std::vector<Task>& tasks, const bool& filterBool, const std::string& CatPrioStat) {
+// Asks for a whole number in [min, max]. Returns 0 if the user exits.
+int numberPrompt(int min, int max) {
+	std::string value;
+	while (true) {
+		std::cout << "[Enter 0 to exit.]" << std::endl;
+		std::cout << "-> ";
+		std::getline(std::cin, value);
+		if (value == EXIT_STR) {
+			return 0;
+		}
+		try {
+			int number = std::stoi(value);
+			if (number >= min && number <= max) {
+				return number;
+			}
+		}
+		catch (const std::logic_error&) {}
+		std::cout << "\n\033[31mNot a valid Input.\033[0m\nEnter a number from " << min << " to " << max << "." << std::endl;
+	}
+}
+
+
+// Works for std::vector<Task> as well as TaskBatch.
+template <typename TaskRange>
+void printMany(const TaskRange& tasks, const bool& filterBool, const std::string& CatPrioStat) {
 	std::cout << "\n--------------------------------------------------------------------------" << std::endl;
 	if (tasks.size() == 0 && filterBool) {
 		std::cout << "\n\033[31mNo Tasks with '\033[0m" << CatPrioStat << "\033[31m' found.\033[0m" << std::endl;
@@ -607,7 +3858,7 @@ void printMany(const std::vector<Task>& tasks, const bool& filterBool, const std
 		else {
 			std::cout << "Tasks:\n" << std::endl;
 		}	
-		for (const Task& task : tasks) {
+		for (const auto& task : tasks) {
 			task.print();
 		}
 		std::cout << "--------------------------------------------------------------------------\n" << std::endl;
@@ -622,15 +3873,16 @@ void createJSON(const TaskManager& taskmanager) {
         return;
     }
 
-	std::vector<Task> tasks = taskmanager.getAllTasks();
+	TaskBatch tasks(taskmanager.countTasks());
+	taskmanager.getAllTasks(tasks);
 
 	file << "{\"tasks\": [\n";
 	for (size_t i = 0; i < tasks.size(); i++) {
-		file << "{\"title\": \"" << tasks[i].getTitle() << "\", ";
-		file << "\"category\": \"" << tasks[i].getCategory() << "\", ";
-		file << "\"dueDate\": \"" << tasks[i].getDueDate() << "\", ";
-		file << "\"priority\": \"" << PrioToStr(tasks[i].getPriority()) << "\", ";
-		file << "\"status\": \"" << StatToStr(tasks[i].getStatus()) << "\"}";
+		file << "{\"title\": \"" << tasks[i].title << "\", ";
+		file << "\"category\": \"" << tasks[i].category << "\", ";
+		file << "\"dueDate\": \"" << tasks[i].dueDate << "\", ";
+		file << "\"priority\": \"" << PrioToStr(tasks[i].priority) << "\", ";
+		file << "\"status\": \"" << StatToStr(tasks[i].status) << "\"}";
 		if (i != tasks.size() - 1) {
 			file << ",\n";
 		}
@@ -641,11 +3893,370 @@ void createJSON(const TaskManager& taskmanager) {
 
 
 
-int main() {
+// Parses the conditions of a scripted bulk command, e.g. 'category=work status=open overdue'.
+TaskFilter parseFilter(const std::vector<std::string>& args, size_t first) {
+	TaskFilter filter;
+	for (size_t i = first; i < args.size(); i++) {
+		const std::string& arg = args[i];
+		size_t eq = arg.find('=');
+		std::string key = arg.substr(0, eq);
+		std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+		if (key == "overdue" && eq == std::string::npos) {
+			filter.dueBefore = todayStr();
+		}
+		else if (key == "category" && !value.empty()) {
+			std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+			filter.category = value;
+		}
+		else if (key == "priority") {
+			filter.priority = strToPrio(value);
+		}
+		else if (key == "status") {
+			filter.status = strToStat(value);
+		}
+		else if (key == "due-before" && isValidDate(value)) {
+			filter.dueBefore = value;
+		}
+		else {
+			throw std::invalid_argument("\033[31mInvalid Condition:\033[0m " + arg);
+		}
+	}
+	return filter;
+}
+
+void removeDatabaseFiles(const std::string& path) {
+	for (const char* suffix : {"", "-journal", "-wal", "-shm"}) {
+		std::remove((path + suffix).c_str());
+	}
+}
+
+// Measures write and read throughput of every storage profile on a scratch database in ./data.
+// Writes go through addTask, so every task is its own transaction. Reads are full sorted reads,
+// once into a TaskBatch arena and once into a std::vector<Task> (three strings per row).
+// The last row writes durably into 'shards' files from one thread per shard, to compare
+// ShardedTaskManager with the single durable file.
+void runBenchmark(size_t rows, size_t shards) {
+	const int READ_PASSES = 10;
+	const std::vector<StorageProfile> profiles = {StorageProfile::Durable, StorageProfile::Balanced,
+		StorageProfile::Fast, StorageProfile::InMemory};
+
+	std::cout << "Benchmark: " << rows << " single-task writes, " << READ_PASSES << " full sorted reads\n" << std::endl;
+	std::cout << std::left << std::setw(12) << "Profile" << std::right << std::setw(14) << "Writes/s"
+			  << std::setw(20) << "Rows read/s batch" << std::setw(20) << "Rows read/s vector" << std::endl;
+
+	for (StorageProfile profile : profiles) {
+		const std::string path = "./data/bench_" + ProfileToStr(profile) + ".db";
+		removeDatabaseFiles(path);
+
+		std::chrono::duration<double> writeTime, readTime, vectorReadTime;
+		{
+			TaskManager manager(path, profile);
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < rows; i++) {
+				manager.addTask(Task("bench task " + std::to_string(i), "bench", "01-01-2027",
+					static_cast<Priority>(i % 3), static_cast<Status>(i % 3)));
+			}
+			manager.persist();
+			writeTime = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			for (int pass = 0; pass < READ_PASSES; pass++) {
+				TaskBatch batch(rows);
+				manager.sortByTitle(batch);
+			}
+			readTime = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			for (int pass = 0; pass < READ_PASSES; pass++) {
+				std::vector<Task> tasks = manager.sortByTitle();
+			}
+			vectorReadTime = std::chrono::steady_clock::now() - start;
+		}
+		removeDatabaseFiles(path);
+
+		std::cout << std::left << std::setw(12) << ProfileToStr(profile) << std::right << std::fixed << std::setprecision(0)
+				  << std::setw(14) << rows / writeTime.count()
+				  << std::setw(20) << rows * READ_PASSES / readTime.count()
+				  << std::setw(20) << rows * READ_PASSES / vectorReadTime.count() << std::endl;
+	}
+
+	const std::string shardPrefix = "./data/bench_sharded";
+	for (size_t i = 0; i < shards; i++) {
+		removeDatabaseFiles(shardPrefix + ".shard" + std::to_string(i) + ".db");
+	}
+
+	std::chrono::duration<double> writeTime, vectorReadTime;
+	size_t stored;
+	{
+		ShardedTaskManager sharded(shards, shardPrefix, StorageProfile::Durable);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> writers;
+		for (size_t writer = 0; writer < shards; writer++) {
+			writers.emplace_back([&sharded, rows, shards, writer] {
+				for (size_t i = writer; i < rows; i += shards) {
+					sharded.addTask(Task("bench task " + std::to_string(i), "bench " + std::to_string(i % 64), "01-01-2027",
+						static_cast<Priority>(i % 3), static_cast<Status>(i % 3)));
+				}
+			});
+		}
+		for (std::thread& writer : writers) {
+			writer.join();
+		}
+		writeTime = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < READ_PASSES; pass++) {
+			std::vector<Task> tasks = sharded.sortByTitle();
+		}
+		vectorReadTime = std::chrono::steady_clock::now() - start;
+		stored = sharded.countTasks();
+	}
+	for (size_t i = 0; i < shards; i++) {
+		removeDatabaseFiles(shardPrefix + ".shard" + std::to_string(i) + ".db");
+	}
+
+	std::cout << std::left << std::setw(12) << ("durable x" + std::to_string(shards)) << std::right << std::fixed << std::setprecision(0)
+			  << std::setw(14) << rows / writeTime.count()
+			  << std::setw(20) << "-"
+			  << std::setw(20) << rows * READ_PASSES / vectorReadTime.count() << std::endl;
+	if (stored != rows) {
+		std::cout << "\033[31mSharded run stored " << stored << " of " << rows << " tasks.\033[0m" << std::endl;
+	}
+}
+
+// Measures the in-memory dependency graph on 'tasks' nodes with three random edges per
+// node: the bulk load, incremental edge inserts, status flips, work order and critical path.
+void runGraphBenchmark(size_t tasks) {
+	const size_t EDGES_PER_TASK = 3;
+	const size_t INSERTS = 10000;
+	const size_t FLIPS = 100000;
+
+	if (tasks < 2) {
+		return;
+	}
+	std::mt19937 random(42);
+	std::uniform_int_distribution<size_t> pick(0, tasks - 1);
+
+	// Edges follow a hidden random order, so the graph is acyclic but not trivially sorted.
+	std::vector<uint32_t> hidden(tasks);
+	for (size_t i = 0; i < tasks; i++) {
+		hidden[i] = static_cast<uint32_t>(i);
+	}
+	std::shuffle(hidden.begin(), hidden.end(), random);
+	std::vector<std::pair<uint32_t, uint32_t>> edges;
+	edges.reserve(tasks * EDGES_PER_TASK);
+	while (edges.size() < tasks * EDGES_PER_TASK) {
+		size_t a = pick(random), b = pick(random);
+		if (a != b) {
+			edges.push_back({hidden[std::min(a, b)], hidden[std::max(a, b)]});
+		}
+	}
+
+	std::cout << "\nDependency graph: " << tasks << " tasks, " << edges.size() << " edges\n" << std::endl;
+	auto report = [](const std::string& step, std::chrono::steady_clock::time_point start) {
+		std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+		std::cout << std::left << std::setw(28) << step << std::right << std::fixed << std::setprecision(0)
+				  << std::setw(10) << took.count() << " ms" << std::endl;
+	};
+
+	DependencyGraph graph;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < tasks; i++) {
+		graph.addNode(static_cast<uint32_t>(i), static_cast<long long>(i % 365), false);
+	}
+	graph.build(edges);
+	report("Build (Kahn)", start);
+
+	start = std::chrono::steady_clock::now();
+	size_t accepted = 0;
+	for (size_t i = 0; i < INSERTS; i++) {
+		uint32_t a = static_cast<uint32_t>(pick(random)), b = static_cast<uint32_t>(pick(random));
+		if (a != b && !graph.hasEdge(a, b) && graph.addEdge(a, b)) {
+			accepted++;
+		}
+	}
+	report(std::to_string(INSERTS) + " edge inserts", start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < FLIPS; i++) {
+		graph.setDone(static_cast<uint32_t>(pick(random)), i % 2 == 0);
+	}
+	report(std::to_string(FLIPS) + " status flips", start);
+
+	start = std::chrono::steady_clock::now();
+	size_t ordered = graph.workOrder().size();
+	report("Work order", start);
+
+	start = std::chrono::steady_clock::now();
+	size_t chain = graph.criticalPath().size();
+	report("Critical path", start);
+
+	std::cout << accepted << " inserts accepted (the rest would close a cycle), " << ordered
+			  << " unfinished tasks ordered, critical path of " << chain << " tasks" << std::endl;
+}
+
+void printUsage() {
+	std::cout << "Usage:\n"
+			  << "  taskmanager [--profile durable|balanced|fast|in-memory] [command]\n"
+			  << "Commands:\n"
+			  << "  (none)                                             Interactive menu\n"
+			  << "  set-status <Open|InProgress|Done> [conditions]\n"
+			  << "  set-priority <Low|Medium|High> [conditions]\n"
+			  << "  remove-where <conditions>\n"
+			  << "  depend <blocker> <blocked>                         <blocked> waits until <blocker> is done\n"
+			  << "  undepend <blocker> <blocked>\n"
+			  << "  order | unblocked | critical-path                  Work order / startable tasks / longest chain\n"
+			  << "  tag <title> <tag> | untag <title> <tag>\n"
+			  << "  tags <expression>                                  e.g. \"urgent AND backend AND NOT waiting\"\n"
+			  << "  next [k]                                           The k tasks to work on next (default 5)\n"
+			  << "  recur <title> <category> <DD-MM-YYYY> <priority> <days:N|weeks:N|weekday:mon|monthday:D> [until <DD-MM-YYYY>]\n"
+			  << "  unrecur <title> | recurrences                      Remove / list recurring tasks\n"
+			  << "  list [<from> <to>]                                 All tasks by title, occurrences due from..to (DD-MM-YYYY)\n"
+			  << "  bench [rows] [shards] [graph-tasks]                Throughput of every storage profile, of sharded files\n"
+			  << "                                                     and of the dependency graph (default 1000000 tasks)\n"
+			  << "Conditions: category=<name> priority=<level> status=<level> due-before=<DD-MM-YYYY> overdue" << std::endl;
+}
+
+// Scripted use: runs one command given on the command line and returns the exit code.
+int runCommand(TaskManager& taskmanager, const std::vector<std::string>& args) {
+	try {
+		const std::string& command = args[0];
+		if (command == "set-status" && args.size() >= 2) {
+			size_t changed = taskmanager.setStatusWhere(parseFilter(args, 2), strToStat(args[1]));
+			std::cout << "Changed Status of " << changed << " Tasks." << std::endl;
+			return 0;
+		}
+		if (command == "set-priority" && args.size() >= 2) {
+			size_t changed = taskmanager.setPriorityWhere(parseFilter(args, 2), strToPrio(args[1]));
+			std::cout << "Changed Priority of " << changed << " Tasks." << std::endl;
+			return 0;
+		}
+		if (command == "next") {
+			size_t k = args.size() > 1 ? std::stoul(args[1]) : 5;
+			printMany(taskmanager.nextTasks(k), false, "");
+			return 0;
+		}
+		if ((command == "depend" || command == "undepend") && args.size() == 3) {
+			std::string blocker = args[1], blocked = args[2];
+			std::transform(blocker.begin(), blocker.end(), blocker.begin(), ::tolower);
+			std::transform(blocked.begin(), blocked.end(), blocked.begin(), ::tolower);
+			bool changed = command == "depend" ? taskmanager.addDependency(blocker, blocked) : taskmanager.removeDependency(blocker, blocked);
+			return changed ? 0 : 1;
+		}
+		if ((command == "tag" || command == "untag") && args.size() == 3) {
+			std::string title = args[1];
+			std::transform(title.begin(), title.end(), title.begin(), ::tolower);
+			bool changed = command == "tag" ? taskmanager.addTag(title, args[2]) : taskmanager.removeTag(title, args[2]);
+			return changed ? 0 : 1;
+		}
+		if (command == "tags" && args.size() >= 2) {
+			std::string expression;
+			for (size_t i = 1; i < args.size(); i++) {
+				expression += (i > 1 ? " " : "") + args[i];
+			}
+			printMany(taskmanager.filterByTags(expression), true, expression);
+			return 0;
+		}
+		if (command == "recur" && (args.size() == 6 || (args.size() == 8 && args[6] == "until"))) {
+			RecurrenceRule rule;
+			rule.title = args[1];
+			rule.category = args[2];
+			std::transform(rule.title.begin(), rule.title.end(), rule.title.begin(), ::tolower);
+			std::transform(rule.category.begin(), rule.category.end(), rule.category.begin(), ::tolower);
+			rule.startDate = args[3];
+			rule.priority = strToPrio(args[4]);
+			std::tie(rule.repeat, rule.every) = strToRepeat(args[5]);
+			if (args.size() == 8) {
+				rule.endDate = args[7];
+			}
+			if (!isValidDate(rule.startDate) || (rule.endDate && !isValidDate(*rule.endDate))) {
+				throw std::invalid_argument("\033[31mDates have to be DD-MM-YYYY.\033[0m");
+			}
+			return taskmanager.addRecurrence(rule) ? 0 : 1;
+		}
+		if (command == "unrecur" && args.size() == 2) {
+			std::string title = args[1];
+			std::transform(title.begin(), title.end(), title.begin(), ::tolower);
+			return taskmanager.removeRecurrence(title) ? 0 : 1;
+		}
+		if (command == "recurrences") {
+			printRecurrences(taskmanager.getRecurrences());
+			return 0;
+		}
+		if (command == "list" && (args.size() == 1 || args.size() == 3)) {
+			if (args.size() == 3) {
+				if (!isValidDate(args[1]) || !isValidDate(args[2])) {
+					throw std::invalid_argument("\033[31mDates have to be DD-MM-YYYY.\033[0m");
+				}
+				taskmanager.setRecurrenceWindow(args[1], args[2]);
+			}
+			TaskBatch batch(taskmanager.countTasks());
+			taskmanager.sortByTitle(batch);
+			printMany(batch, false, "");
+			return 0;
+		}
+		if (command == "order") {
+			printMany(taskmanager.getWorkOrder(), false, "");
+			return 0;
+		}
+		if (command == "unblocked") {
+			printMany(taskmanager.getUnblockedTasks(), false, "");
+			return 0;
+		}
+		if (command == "critical-path") {
+			printMany(taskmanager.getCriticalPath(), false, "");
+			return 0;
+		}
+		if (command == "remove-where") {
+			TaskFilter filter = parseFilter(args, 1);
+			if (filter.empty()) {
+				std::cerr << "\033[31mremove-where needs at least one condition.\033[0m" << std::endl;
+				return 1;
+			}
+			size_t removed = taskmanager.removeWhere(filter);
+			std::cout << "Removed " << removed << " Tasks." << std::endl;
+			return 0;
+		}
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	catch (const std::out_of_range& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	printUsage();
+	return 1;
+}
+
+
+int main(int argc, char* argv[]) {
 
 	try {
 
-		TaskManager taskmanager;
+		const int IN_MEMORY_PERSIST_SECONDS = 60;
+
+		std::vector<std::string> args(argv + 1, argv + argc);
+		StorageProfile profile = StorageProfile::Durable;
+		if (args.size() >= 2 && args[0] == "--profile") {
+			profile = strToProfile(args[1]);
+			args.erase(args.begin(), args.begin() + 2);
+		}
+		if (!args.empty() && args[0] == "bench") {
+			runBenchmark(args.size() > 1 ? std::stoul(args[1]) : 5000, args.size() > 2 ? std::stoul(args[2]) : 4);
+			runGraphBenchmark(args.size() > 3 ? std::stoul(args[3]) : 1000000);
+			return 0;
+		}
+
+		TaskManager taskmanager("./data/tasks_sql.db", profile, profile == StorageProfile::InMemory ? IN_MEMORY_PERSIST_SECONDS : 0);
+
+		if (!args.empty()) {
+			return runCommand(taskmanager, args);
+		}
 
 		// Test examples
 		/*
@@ -661,20 +4272,32 @@ int main() {
 
 
 		int inpChoice;
-		std::string title, category, dueDate, priorityStr, statusStr, inpMenu, inpChange, inpSort;
+		std::string title, category, dueDate, priorityStr, statusStr, inpMenu, inpChange, inpSort, inpBulk, inpOverdue, inpConfirm, inpCount, inpDepend, inpTag, tagStr, inpRecur, inpRepeat;
 		std::string emptyStr = "";
 		std::vector<std::string> PrioStrVec   = {"Low", "Medium", "High"};
 		std::vector<std::string> StatStrVec   = {"Open", "InProgress", "In Progress", "Done"};
-		std::vector<std::string> ChangeStrVec = {"1", "2"};
+		std::vector<std::string> ChangeStrVec = {"1", "2", "3"};
+		std::vector<std::string> TagStrVec    = {"1", "2"};
 		std::vector<std::string> SortStrVec   = {"1", "2", "3", "4"};
+		std::vector<std::string> BulkStrVec   = {"1", "2", "3"};
+		std::vector<std::string> DependStrVec = {"1", "2", "3", "4", "5"};
+		std::vector<std::string> RecurStrVec  = {"1", "2", "3"};
+		std::vector<std::string> RepeatStrVec = {"1", "2", "3", "4"};
+		std::vector<std::string> YesNoStrVec  = {"yes", "no"};
 		
+		std::optional<uint64_t> exportedGeneration;
 		do {
-			createJSON(taskmanager);
+			// Pick up writes of other processes, then re-export only if the tasks changed.
+			taskmanager.refreshIfChanged();
+			if (exportedGeneration != taskmanager.getGeneration()) {
+				createJSON(taskmanager);
+				exportedGeneration = taskmanager.getGeneration();
+			}
 
 			std::cout << "\n**************************************************************************" << std::endl;
-			std::cout << "Task Manager:\n1: Add Task\n2: Remove Task\n3: Find Task\n4: Change Status/Priority" <<
+			std::cout << "Task Manager:\n1: Add Task\n2: Remove Task\n3: Find Task\n4: Change Status/Priority/Tags" <<
 						"\n5: List available Tasks\n6: Filter by Category\n7: Filter by Priority" <<
-						"\n8: Filter by Status\n9: Sort Tasks\n0: End\n-> ";
+						"\n8: Filter by Status\n9: Sort Tasks\n10: Bulk Change/Remove\n11: Next Tasks\n12: Dependencies\n13: Filter by Tags\n14: Recurring Tasks\n0: End\n-> ";
 
 			std::getline(std::cin, inpMenu);
 			try {
@@ -744,15 +4367,15 @@ int main() {
 					foundTask->print();
 					break;
 				}
-				case 4: { // Change Status/Priority
-					std::cout << "\nChange Status/Priority" << std::endl;
+				case 4: { // Change Status/Priority/Tags
+					std::cout << "\nChange Status/Priority/Tags" << std::endl;
 					std::optional<Task> foundTask = findTaskPrompt(taskmanager);
 					if (foundTask == std::nullopt) { break ;}
 
 					std::cout << std::endl;
 					foundTask->print();
 					
-					std::cout << "\nChange Status (1) / Priority (2):\n";
+					std::cout << "\nChange Status (1) / Priority (2) / Tags (3):\n";
 					inpChange = checkInputPrompt(ChangeStrVec);
 					if (inpChange == EXIT_STR) { break; }
 					
@@ -780,10 +4403,44 @@ int main() {
 						if (changedTask == std::nullopt) { break; }
 						std::cout << "\033[32m' to '\033[0m" << PrioToStr(changedTask.value().getPriority()) << "\033[32m'.\033[0m" << std::endl;
 					}
+					if (inpChange == "3") {
+						std::vector<std::string> tags = taskmanager.getTags(foundTask->getTitle());
+						std::cout << "\nTags:";
+						for (const std::string& tag : tags) {
+							std::cout << " " << tag;
+						}
+						std::cout << "\nAdd Tag (1) / Remove Tag (2):\n";
+						inpTag = checkInputPrompt(TagStrVec);
+						if (inpTag == EXIT_STR) { break; }
+
+						if (inpTag == "1") {
+							std::cout << "\nEnter Tag (one word, not AND/OR/NOT):\n[Enter 0 to exit.]\n-> ";
+							std::getline(std::cin, tagStr);
+							while (tagStr != EXIT_STR && !tagStr.empty() && !TagQuery::isValidTag(tagStr)) {
+								std::cout << "\033[31mInvalid Tag.\033[0m\n-> ";
+								std::getline(std::cin, tagStr);
+							}
+							if (tagStr == EXIT_STR || tagStr.empty()) { break; }
+							std::transform(tagStr.begin(), tagStr.end(), tagStr.begin(), ::tolower);
+							if (taskmanager.addTag(foundTask->getTitle(), tagStr)) {
+								std::cout << "\n\033[32mTagged '\033[0m" << foundTask->getTitle() << "\033[32m' with '\033[0m" << tagStr << "\033[32m'.\033[0m" << std::endl;
+							}
+						}
+						else if (inpTag == "2") {
+							if (tags.empty()) { break; }
+							std::cout << "\nEnter Tag:" << std::endl;
+							tagStr = checkInputPrompt(tags);
+							if (tagStr == EXIT_STR) { break; }
+							if (taskmanager.removeTag(foundTask->getTitle(), tagStr)) {
+								std::cout << "\n\033[32mRemoved Tag '\033[0m" << tagStr << "\033[32m' from '\033[0m" << foundTask->getTitle() << "\033[32m'.\033[0m" << std::endl;
+							}
+						}
+					}
 					break;
 				}
 				case 5: { // List All Tasks
-					std::vector<Task> allTasks = taskmanager.getAllTasks();
+					TaskBatch allTasks(taskmanager.countTasks());
+					taskmanager.getAllTasks(allTasks);
 					printMany(allTasks, false, emptyStr);
 					break;
 				}
@@ -792,7 +4449,10 @@ int main() {
 					category = checkInputPrompt(taskmanager.getAvailableCategories());
 					if (category == EXIT_STR) { break; }
 
-					std::vector<Task> filteredTasks = taskmanager.filterByCategory(category);
+					TaskFilter filter;
+					filter.category = category;
+					TaskBatch filteredTasks(taskmanager.countTasks(filter));
+					taskmanager.filterByCategory(category, filteredTasks);
 					printMany(filteredTasks, true, category);
 					break;
 				}
@@ -801,7 +4461,10 @@ int main() {
 					priorityStr = checkInputPrompt(taskmanager.getAvailablePriorities());
 					if (priorityStr == EXIT_STR) { break; }
 					
-					std::vector<Task> filteredTasks = taskmanager.filterByPriority(strToPrio(priorityStr));
+					TaskFilter filter;
+					filter.priority = strToPrio(priorityStr);
+					TaskBatch filteredTasks(taskmanager.countTasks(filter));
+					taskmanager.filterByPriority(*filter.priority, filteredTasks);
 					printMany(filteredTasks, true, priorityStr);
 					break;
 				}
@@ -810,29 +4473,237 @@ int main() {
 					statusStr = checkInputPrompt(taskmanager.getAvailableStatuses());
 					if (statusStr == EXIT_STR) { break; }
 
-					std::vector<Task> filteredTasks = taskmanager.filterByStatus(strToStat(statusStr));
+					TaskFilter filter;
+					filter.status = strToStat(statusStr);
+					TaskBatch filteredTasks(taskmanager.countTasks(filter));
+					taskmanager.filterByStatus(*filter.status, filteredTasks);
 					printMany(filteredTasks, true, statusStr);
 					break;
 				}
-				case 9: // Sort alphabetically / by Priority
+				case 9: { // Sort alphabetically / by Priority
 					std::cout << "\nSort Alphabetically (1) / By Category (2) / By Priority (3) / By Status (4):\n";
 					inpSort = checkInputPrompt(SortStrVec);
 					if (inpSort == EXIT_STR) { break; }
 
+					TaskBatch orderedTasks(taskmanager.countTasks());
 					if (inpSort == "1") {
-						printMany(taskmanager.sortByTitle(), false, emptyStr);
+						taskmanager.sortByTitle(orderedTasks);
 					}
 					else if (inpSort == "2") {
-						printMany(taskmanager.sortByCategory(), false, emptyStr);
+						taskmanager.sortByCategory(orderedTasks);
 					}
 					else if (inpSort == "3") {
-						printMany(taskmanager.sortByPriority(), false, emptyStr);
-						
+						taskmanager.sortByPriority(orderedTasks);
 					}
 					else if (inpSort == "4") {
-						printMany(taskmanager.sortByStatus(), false, emptyStr);
+						taskmanager.sortByStatus(orderedTasks);
+					}
+					printMany(orderedTasks, false, emptyStr);
+					break;
+				}
+				case 10: { // Bulk Change/Remove
+					std::cout << "\nBulk Change/Remove\nChange Status (1) / Priority (2) / Remove (3):\n";
+					inpBulk = checkInputPrompt(BulkStrVec);
+					if (inpBulk == EXIT_STR) { break; }
+
+					TaskFilter filter;
+					std::vector<std::string> categories = taskmanager.getAvailableCategories();
+					categories.push_back("all");
+					std::cout << "\nOnly Tasks of Category (or 'all'):" << std::endl;
+					category = checkInputPrompt(categories);
+					if (category == EXIT_STR) { break; }
+					if (category != "all") { filter.category = category; }
+
+					std::vector<std::string> priorities = PrioStrVec;
+					priorities.push_back("all");
+					std::cout << "\nOnly Tasks of Priority (Low/Medium/High/all):" << std::endl;
+					priorityStr = checkInputPrompt(priorities);
+					if (priorityStr == EXIT_STR) { break; }
+					if (priorityStr != "all") { filter.priority = strToPrio(priorityStr); }
+
+					std::vector<std::string> statuses = StatStrVec;
+					statuses.push_back("all");
+					std::cout << "\nOnly Tasks of Status (Open/InProgress/Done/all):" << std::endl;
+					statusStr = checkInputPrompt(statuses);
+					if (statusStr == EXIT_STR) { break; }
+					if (statusStr != "all") { filter.status = strToStat(statusStr); }
+
+					std::cout << "\nOnly overdue Tasks (yes/no):" << std::endl;
+					inpOverdue = checkInputPrompt(YesNoStrVec);
+					if (inpOverdue == EXIT_STR) { break; }
+					if (inpOverdue == "yes") { filter.dueBefore = todayStr(); }
+
+					if (inpBulk == "1") {
+						std::cout << "\nEnter new Task Status (Open/InProgress/Done):\n";
+						statusStr = checkInputPrompt(StatStrVec);
+						if (statusStr == EXIT_STR) { break; }
+						size_t changed = taskmanager.setStatusWhere(filter, strToStat(statusStr));
+						std::cout << "\n\033[32mChanged Status of\033[0m " << changed << " \033[32mTasks.\033[0m" << std::endl;
+					}
+					else if (inpBulk == "2") {
+						std::cout << "\nEnter new Task Priority (Low/Medium/High):\n";
+						priorityStr = checkInputPrompt(PrioStrVec);
+						if (priorityStr == EXIT_STR) { break; }
+						size_t changed = taskmanager.setPriorityWhere(filter, strToPrio(priorityStr));
+						std::cout << "\n\033[32mChanged Priority of\033[0m " << changed << " \033[32mTasks.\033[0m" << std::endl;
+					}
+					else if (inpBulk == "3") {
+						std::cout << "\nRemove all matching Tasks (yes/no):" << std::endl;
+						inpConfirm = checkInputPrompt(YesNoStrVec);
+						if (inpConfirm != "yes") { break; }
+						size_t removed = taskmanager.removeWhere(filter);
+						std::cout << "\n\033[32mRemoved\033[0m " << removed << " \033[32mTasks.\033[0m" << std::endl;
+					}
+					break;
+				}
+				case 11: { // Next Tasks
+					std::cout << "\nNext Tasks\nEnter number of Tasks:\n[Enter 0 to exit.]\n-> ";
+					std::getline(std::cin, inpCount);
+					if (inpCount == EXIT_STR) { break; }
+
+					int count;
+					try {
+						count = std::stoi(inpCount);
+					}
+					catch (std::exception&) {
+						std::cout << "\n\033[31mInvalid Input.\033[0m" << std::endl;
+						break;
+					}
+					if (count <= 0) {
+						std::cout << "\n\033[31mInvalid Input.\033[0m" << std::endl;
+						break;
+					}
+					printMany(taskmanager.nextTasks(count), false, emptyStr);
+					break;
+				}
+				case 12: { // Dependencies
+					std::cout << "\nDependencies\nAdd (1) / Remove (2) / Work Order (3) / Unblocked Tasks (4) / Critical Path (5):\n";
+					inpDepend = checkInputPrompt(DependStrVec);
+					if (inpDepend == EXIT_STR) { break; }
+
+					if (inpDepend == "1" || inpDepend == "2") {
+						std::cout << "\nBlocking Task" << std::endl;
+						std::optional<Task> blocker = findTaskPrompt(taskmanager);
+						if (blocker == std::nullopt) { break; }
+						std::cout << "\nBlocked Task" << std::endl;
+						std::optional<Task> blocked = findTaskPrompt(taskmanager);
+						if (blocked == std::nullopt) { break; }
+
+						if (inpDepend == "1" && taskmanager.addDependency(blocker->getTitle(), blocked->getTitle())) {
+							std::cout << "\n\033[32m'\033[0m" << blocked->getTitle() << "\033[32m' now waits on '\033[0m" << blocker->getTitle() << "\033[32m'.\033[0m" << std::endl;
+						}
+						else if (inpDepend == "2" && taskmanager.removeDependency(blocker->getTitle(), blocked->getTitle())) {
+							std::cout << "\n\033[32m'\033[0m" << blocked->getTitle() << "\033[32m' no longer waits on '\033[0m" << blocker->getTitle() << "\033[32m'.\033[0m" << std::endl;
+						}
+						else {
+							std::cout << "\n\033[31mDependency not changed.\033[0m" << std::endl;
+						}
+					}
+					else if (inpDepend == "3") {
+						printMany(taskmanager.getWorkOrder(), false, emptyStr);
+					}
+					else if (inpDepend == "4") {
+						printMany(taskmanager.getUnblockedTasks(), false, emptyStr);
+					}
+					else if (inpDepend == "5") {
+						printMany(taskmanager.getCriticalPath(), false, emptyStr);
+					}
+					break;
+				}
+				case 13: { // Filter by Tags
+					std::cout << "\nFilter by Tags\nAvailable Tags:";
+					for (const std::string& tag : taskmanager.getAvailableTags()) {
+						std::cout << " " << tag;
+					}
+					std::cout << "\nEnter Tag filter (e.g. urgent AND backend AND NOT waiting):\n[Enter 0 to exit.]\n-> ";
+					std::getline(std::cin, tagStr);
+					if (tagStr == EXIT_STR) { break; }
+
+					try {
+						printMany(taskmanager.filterByTags(tagStr), true, tagStr);
+					}
+					catch (const std::invalid_argument& e) {
+						std::cout << "\n" << e.what() << std::endl;
+					}
+					break;
+				}
+				case 14: { // Recurring Tasks
+					std::cout << "\nRecurring Tasks\nAdd (1) / Remove (2) / List (3):\n";
+					inpRecur = checkInputPrompt(RecurStrVec);
+					if (inpRecur == EXIT_STR) { break; }
+
+					if (inpRecur == "1") {
+						RecurrenceRule rule;
+						std::cout << "\nEnter Recurring Task Title:\n[Enter 0 to exit.]\n-> ";
+						std::getline(std::cin, rule.title);
+						if (rule.title == EXIT_STR) { break; }
+						std::transform(rule.title.begin(), rule.title.end(), rule.title.begin(), ::tolower);
+
+						std::cout << "\nEnter Task Category:\n[Enter 0 to exit.]\n-> ";
+						std::getline(std::cin, rule.category);
+						if (rule.category == EXIT_STR) { break; }
+						std::transform(rule.category.begin(), rule.category.end(), rule.category.begin(), ::tolower);
+
+						std::cout << "\nEnter first Due Date (DD-MM-YYYY):\n[Enter 0 to exit.]" << std::endl;
+						rule.startDate = valiDATE();
+						if (rule.startDate == EXIT_STR) { break; }
+
+						std::cout << "\nEnter Task Priority (Low/Medium/High):" << std::endl;
+						priorityStr = checkInputPrompt(PrioStrVec);
+						if (priorityStr == EXIT_STR) { break; }
+						rule.priority = strToPrio(priorityStr);
+
+						std::cout << "\nRepeat every N Days (1) / every N Weeks (2) / on a Weekday (3) / on a Day of the Month (4):" << std::endl;
+						inpRepeat = checkInputPrompt(RepeatStrVec);
+						if (inpRepeat == EXIT_STR) { break; }
+
+						if (inpRepeat == "1" || inpRepeat == "2") {
+							rule.repeat = inpRepeat == "1" ? Repeat::Days : Repeat::Weeks;
+							std::cout << "\nEnter N:" << std::endl;
+							rule.every = numberPrompt(1, 365);
+						}
+						else if (inpRepeat == "3") {
+							rule.repeat = Repeat::Weekday;
+							std::cout << "\nEnter Weekday (Mon/Tue/Wed/Thu/Fri/Sat/Sun):" << std::endl;
+							std::string weekday = checkInputPrompt(WEEKDAY_STRS);
+							if (weekday == EXIT_STR) { break; }
+							rule.every = strToRepeat("weekday:" + weekday).second;
+						}
+						else {
+							rule.repeat = Repeat::MonthDay;
+							std::cout << "\nEnter Day of the Month (1-31, shorter months use their last day):" << std::endl;
+							rule.every = numberPrompt(1, 31);
+						}
+						if (rule.repeat != Repeat::Weekday && rule.every == 0) { break; }
+
+						if (taskmanager.addRecurrence(rule)) {
+							std::cout << "\n\033[32mAdded recurring Task\033[0m '" << rule.title << "\033[32m'.\033[0m" << std::endl;
+						}
+						else {
+							std::cout << "\n\033[31mCould not add\033[0m '" << rule.title << "\033[31m'.\033[0m" << std::endl;
+						}
+					}
+					else if (inpRecur == "2") {
+						std::vector<std::string> ruleTitles;
+						for (const RecurrenceRule& rule : taskmanager.getRecurrences()) {
+							ruleTitles.push_back(rule.title);
+						}
+						std::cout << "\nEnter Recurring Task Title (stored occurrences are kept):" << std::endl;
+						title = checkInputPrompt(ruleTitles);
+						if (title == EXIT_STR) { break; }
+
+						if (taskmanager.removeRecurrence(title)) {
+							std::cout << "\n\033[32mRemoved recurring Task '\033[0m" << title << "\033[32m'.\033[0m" << std::endl;
+						}
+						else {
+							std::cout << "\n\033[31mCould not remove\033[0m '" << title << "\033[31m'.\033[0m" << std::endl;
+						}
+					}
+					else {
+						printRecurrences(taskmanager.getRecurrences());
 					}
 					break;
+				}
 				default:
 					std::cout << "\n\033[31mInvalid Input.\033[0m" << std::endl;
 			}
@@ -845,6 +4716,10 @@ int main() {
 		std::cerr << e.what() << std::endl;
 		return 1;
 	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
 }
 
 /*